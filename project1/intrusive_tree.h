@@ -0,0 +1,516 @@
+/*
+Ordered tree for nodes that carry their own links, shared by the event system (question 1)
+and the package system (question 2). Both used to hand-roll the same insert / find / min /
+remove code on their own node type; now each one names its node and a few policies and
+gets the tree code from here, specialized at compile time, so there's one hot path to tune.
+
+"Intrusive" means the tree never allocates or copies anything to link a node in: the child
+pointers (and the balance data) are members of the node itself. Taking a node out unlinks that
+same node, it's never swapped for a copy of its successor, so pointers to it stay valid.
+
+Policies:
+  KeyOf      where the key is, e.g. MemberKey<EventNode, int, &EventNode::eventId>
+             (keys need < and !=, and must be unique in one tree)
+  Links      which members are the child pointers, ChildLinks<T, &T::left, &T::right>
+  Balancing  NoBalancing, AvlBalancing<T, &T::height> or RedBlackBalancing<T, &T::red>
+  Allocator  where emplace() gets nodes and erase() gives them back, NewAllocator<T> by default.
+             Any type with static create(args...) and destroy(T*) will do, e.g. one over a pool
+
+TreeAlgorithms<...> works on a bare root pointer, the caller keeps its roots itself. insert() and
+unlink() leave the nodes to the caller, emplace() and erase() go through the allocator.
+*/
+
+#ifndef INTRUSIVE_TREE_H
+#define INTRUSIVE_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace intrusive {
+
+// ===== Key and link policies =====
+
+template <typename T, typename K, K T::*Member>
+struct MemberKey {
+    typedef K Key;
+    static const K& get(const T& node) { return node.*Member; }
+};
+
+template <typename T, T* T::*Left, T* T::*Right>
+struct ChildLinks {
+    static T*& left(T* node) { return node->*Left; }
+    static T*& right(T* node) { return node->*Right; }
+};
+
+// ===== Balancing policies =====
+// Each one supplies Ops<T, KeyOf, Links> with
+//   bool insert(T*& root, T* node)                 false (tree untouched) if the key is taken
+//   T* unlink(T*& root, const Key& key)            the node taken out, null if there's none
+//   T* build(T* const* sorted, size_t count)       a tree out of nodes already in key order
+//   size_t depthHint(const T* root)                how deep a walk may go, 0 if it doesn't know
+
+// Plain BST. Everything is a loop, so a degenerate tree (sorted inserts) costs time but can't
+// run out of stack.
+struct NoBalancing {
+    template <typename T, typename KeyOf, typename Links>
+    struct Ops {
+        typedef typename KeyOf::Key Key;
+
+        static bool insert(T*& root, T* node) {
+            const Key& key = KeyOf::get(*node);
+            T** link = &root;
+            while (*link) {
+                const Key& here = KeyOf::get(**link);
+                if (key < here) link = &Links::left(*link);
+                else if (here < key) link = &Links::right(*link);
+                else return false;
+            }
+            Links::left(node) = Links::right(node) = nullptr;
+            *link = node;
+            return true;
+        }
+
+        static T* unlink(T*& root, const Key& key) {
+            T** link = &root;
+            while (*link) {
+                const Key& here = KeyOf::get(**link);
+                if (key < here) link = &Links::left(*link);
+                else if (here < key) link = &Links::right(*link);
+                else break;
+            }
+            T* node = *link;
+            if (!node) return nullptr;
+
+            if (!Links::left(node)) {
+                *link = Links::right(node);
+            } else if (!Links::right(node)) {
+                *link = Links::left(node);
+            } else {
+                // the in-order successor moves into this spot as a whole node
+                T** minLink = &Links::right(node);
+                while (Links::left(*minLink)) minLink = &Links::left(*minLink);
+                T* successor = *minLink;
+                *minLink = Links::right(successor);
+                Links::left(successor) = Links::left(node);
+                Links::right(successor) = Links::right(node);
+                *link = successor;
+            }
+            Links::left(node) = Links::right(node) = nullptr;
+            return node;
+        }
+
+        static T* build(T* const* sorted, size_t count) {
+            if (count == 0) return nullptr;
+            size_t middle = count / 2;
+            T* root = sorted[middle];
+            Links::left(root) = build(sorted, middle);
+            Links::right(root) = build(sorted + middle + 1, count - middle - 1);
+            return root;
+        }
+
+        static size_t depthHint(const T*) { return 0; }
+    };
+};
+
+// AVL: every insert/remove rebalances on the way back up, subtrees differ in height by at most one.
+// Height is the subtree height kept in the node, a leaf is 1.
+template <typename Node, int Node::*Height>
+struct AvlBalancing {
+    template <typename T, typename KeyOf, typename Links>
+    struct Ops {
+        typedef typename KeyOf::Key Key;
+
+        static int height(const T* node) { return node ? node->*Height : 0; }
+
+        static void updateHeight(T* node) {
+            node->*Height = 1 + std::max(height(Links::left(node)), height(Links::right(node)));
+        }
+
+        static T* rotateRight(T* node) {
+            T* newRoot = Links::left(node);
+            Links::left(node) = Links::right(newRoot);
+            Links::right(newRoot) = node;
+            updateHeight(node);
+            updateHeight(newRoot);
+            return newRoot;
+        }
+
+        static T* rotateLeft(T* node) {
+            T* newRoot = Links::right(node);
+            Links::right(node) = Links::left(newRoot);
+            Links::left(newRoot) = node;
+            updateHeight(node);
+            updateHeight(newRoot);
+            return newRoot;
+        }
+
+        // Fixes the height of node and rotates it if one side got more than one level taller
+        static T* rebalance(T* node) {
+            updateHeight(node);
+            int balance = height(Links::left(node)) - height(Links::right(node));
+            if (balance > 1) {
+                // left-right case needs the child straightened out first
+                T* child = Links::left(node);
+                if (height(Links::left(child)) < height(Links::right(child))) Links::left(node) = rotateLeft(child);
+                return rotateRight(node);
+            }
+            if (balance < -1) {
+                T* child = Links::right(node);
+                if (height(Links::right(child)) < height(Links::left(child))) Links::right(node) = rotateRight(child);
+                return rotateLeft(node);
+            }
+            return node;
+        }
+
+        static bool insert(T*& root, T* node) {
+            if (!root) {
+                Links::left(node) = Links::right(node) = nullptr;
+                node->*Height = 1;
+                root = node;
+                return true;
+            }
+            const Key& key = KeyOf::get(*node);
+            const Key& here = KeyOf::get(*root);
+            bool inserted;
+            if (key < here) inserted = insert(Links::left(root), node);
+            else if (here < key) inserted = insert(Links::right(root), node);
+            else return false;
+            if (inserted) root = rebalance(root);
+            return inserted;
+        }
+
+        // Unhooks the smallest node of the subtree (handed back through minNode) and returns the rebalanced subtree
+        static T* detachMin(T* node, T*& minNode) {
+            if (!Links::left(node)) {
+                minNode = node;
+                return Links::right(node);
+            }
+            Links::left(node) = detachMin(Links::left(node), minNode);
+            return rebalance(node);
+        }
+
+        static T* remove(T* root, const Key& key, T*& removed) {
+            if (!root) return nullptr;
+            const Key& here = KeyOf::get(*root);
+            if (key < here) {
+                Links::left(root) = remove(Links::left(root), key, removed);
+            } else if (here < key) {
+                Links::right(root) = remove(Links::right(root), key, removed);
+            } else {
+                removed = root;
+                T* left = Links::left(root);
+                T* right = Links::right(root);
+                Links::left(root) = Links::right(root) = nullptr;
+                if (!left || !right) return left ? left : right;
+
+                // two children: the in-order successor is moved into this spot as a whole node
+                T* successor = nullptr;
+                T* remainingRight = detachMin(right, successor);
+                Links::left(successor) = left;
+                Links::right(successor) = remainingRight;
+                root = successor;
+            }
+            return removed ? rebalance(root) : root;
+        }
+
+        static T* unlink(T*& root, const Key& key) {
+            T* removed = nullptr;
+            root = remove(root, key, removed);
+            return removed;
+        }
+
+        // Perfectly balanced, in O(n)
+        static T* build(T* const* sorted, size_t count) {
+            if (count == 0) return nullptr;
+            size_t middle = count / 2;
+            T* root = sorted[middle];
+            Links::left(root) = build(sorted, middle);
+            Links::right(root) = build(sorted + middle + 1, count - middle - 1);
+            updateHeight(root);
+            return root;
+        }
+
+        static size_t depthHint(const T* root) { return (size_t)height(root); }
+    };
+};
+
+// Left-leaning red-black tree (Sedgewick): a red link always leans left, so insert and remove
+// are a handful of rotations and colour flips on the way back up, with no parent pointers.
+// Red is the colour of the link from the parent, the root is always black.
+template <typename Node, bool Node::*Red>
+struct RedBlackBalancing {
+    template <typename T, typename KeyOf, typename Links>
+    struct Ops {
+        typedef typename KeyOf::Key Key;
+
+        static bool isRed(const T* node) { return node && node->*Red; }
+
+        static T* rotateLeft(T* node) {
+            T* newRoot = Links::right(node);
+            Links::right(node) = Links::left(newRoot);
+            Links::left(newRoot) = node;
+            newRoot->*Red = node->*Red;
+            node->*Red = true;
+            return newRoot;
+        }
+
+        static T* rotateRight(T* node) {
+            T* newRoot = Links::left(node);
+            Links::left(node) = Links::right(newRoot);
+            Links::right(newRoot) = node;
+            newRoot->*Red = node->*Red;
+            node->*Red = true;
+            return newRoot;
+        }
+
+        static void flipColors(T* node) {
+            node->*Red = !(node->*Red);
+            Links::left(node)->*Red = !(Links::left(node)->*Red);
+            Links::right(node)->*Red = !(Links::right(node)->*Red);
+        }
+
+        // Puts back the left-leaning shape on the way up
+        static T* fixUp(T* node) {
+            if (isRed(Links::right(node)) && !isRed(Links::left(node))) node = rotateLeft(node);
+            if (isRed(Links::left(node)) && isRed(Links::left(Links::left(node)))) node = rotateRight(node);
+            if (isRed(Links::left(node)) && isRed(Links::right(node))) flipColors(node);
+            return node;
+        }
+
+        static bool insertAt(T*& root, T* node) {
+            if (!root) {
+                root = node;
+                return true;
+            }
+            const Key& key = KeyOf::get(*node);
+            const Key& here = KeyOf::get(*root);
+            bool inserted;
+            if (key < here) inserted = insertAt(Links::left(root), node);
+            else if (here < key) inserted = insertAt(Links::right(root), node);
+            else return false;
+            if (inserted) root = fixUp(root);
+            return inserted;
+        }
+
+        static bool insert(T*& root, T* node) {
+            Links::left(node) = Links::right(node) = nullptr;
+            node->*Red = true;
+            bool inserted = insertAt(root, node);
+            root->*Red = false;
+            return inserted;
+        }
+
+        // Makes sure the left child or one of its children is red before going down the left
+        static T* moveRedLeft(T* node) {
+            flipColors(node);
+            if (isRed(Links::left(Links::right(node)))) {
+                Links::right(node) = rotateRight(Links::right(node));
+                node = rotateLeft(node);
+                flipColors(node);
+            }
+            return node;
+        }
+
+        static T* moveRedRight(T* node) {
+            flipColors(node);
+            if (isRed(Links::left(Links::left(node)))) {
+                node = rotateRight(node);
+                flipColors(node);
+            }
+            return node;
+        }
+
+        static T* detachMin(T* node, T*& minNode) {
+            if (!Links::left(node)) {
+                minNode = node;   // leaning left, so no left child means no right child either
+                return nullptr;
+            }
+            if (!isRed(Links::left(node)) && !isRed(Links::left(Links::left(node)))) node = moveRedLeft(node);
+            Links::left(node) = detachMin(Links::left(node), minNode);
+            return fixUp(node);
+        }
+
+        // The key has to be in the subtree
+        static T* remove(T* node, const Key& key, T*& removed) {
+            if (key < KeyOf::get(*node)) {
+                if (!isRed(Links::left(node)) && !isRed(Links::left(Links::left(node)))) node = moveRedLeft(node);
+                Links::left(node) = remove(Links::left(node), key, removed);
+            } else {
+                if (isRed(Links::left(node))) node = rotateRight(node);
+                if (!(KeyOf::get(*node) < key) && !Links::right(node)) {
+                    removed = node;
+                    return nullptr;
+                }
+                if (!isRed(Links::right(node)) && !isRed(Links::left(Links::right(node)))) node = moveRedRight(node);
+                if (!(KeyOf::get(*node) < key)) {
+                    // the in-order successor takes this node's place, links and colour
+                    T* successor = nullptr;
+                    T* remainingRight = detachMin(Links::right(node), successor);
+                    Links::left(successor) = Links::left(node);
+                    Links::right(successor) = remainingRight;
+                    successor->*Red = node->*Red;
+                    removed = node;
+                    node = successor;
+                } else {
+                    Links::right(node) = remove(Links::right(node), key, removed);
+                }
+            }
+            return fixUp(node);
+        }
+
+        static T* unlink(T*& root, const Key& key) {
+            T* node = root;
+            while (node) {
+                const Key& here = KeyOf::get(*node);
+                if (key < here) node = Links::left(node);
+                else if (here < key) node = Links::right(node);
+                else break;
+            }
+            if (!node) return nullptr;
+
+            if (!isRed(Links::left(root)) && !isRed(Links::right(root))) root->*Red = true;
+            T* removed = nullptr;
+            root = remove(root, key, removed);
+            if (root) root->*Red = false;
+            Links::left(removed) = Links::right(removed) = nullptr;
+            return removed;
+        }
+
+        // Inserting one by one keeps the colours right without working them out for a given shape
+        static T* build(T* const* sorted, size_t count) {
+            T* root = nullptr;
+            for (size_t i = 0; i < count; i++) insert(root, sorted[i]);
+            return root;
+        }
+
+        static size_t depthHint(const T*) { return 0; }
+    };
+};
+
+// ===== Allocator policy =====
+
+template <typename T>
+struct NewAllocator {
+    template <typename... Args>
+    static T* create(Args&&... args) { return new T(std::forward<Args>(args)...); }
+    static void destroy(T* node) { delete node; }
+};
+
+// ===== Algorithms on a bare root =====
+
+template <typename T, typename KeyOf, typename Links, typename Balancing = NoBalancing,
+          typename Allocator = NewAllocator<T>>
+struct TreeAlgorithms {
+    typedef typename KeyOf::Key Key;
+    typedef typename Balancing::template Ops<T, KeyOf, Links> Ops;
+
+    // The lookup everything else ends up in. With random keys which side to take is a coin flip,
+    // so step() picks the address of the child link and does one load, which compiles to a
+    // conditional move. Picking between the two children directly (or an if/else on two <
+    // compares) gets turned into a branch, and the mispredicts made lookups on a 1M-node tree
+    // about 2x slower. The != first almost never fails, so that branch predicts fine.
+    static T* step(T* node, const Key& key) {
+        T** side = (key < KeyOf::get(*node)) ? &Links::left(node) : &Links::right(node);
+        return *side;
+    }
+
+    static T* find(T* root, const Key& key) {
+        while (root && KeyOf::get(*root) != key) root = step(root, key);
+        return root;
+    }
+
+    // Same, and says how many nodes it looked at (1 for the root)
+    static T* find(T* root, const Key& key, int& depth) {
+        depth = 1;
+        while (root && KeyOf::get(*root) != key) {
+            root = step(root, key);
+            depth++;
+        }
+        return root;
+    }
+
+    static T* minimum(T* root) {
+        while (root && Links::left(root)) root = Links::left(root);
+        return root;
+    }
+
+    static T* maximum(T* root) {
+        while (root && Links::right(root)) root = Links::right(root);
+        return root;
+    }
+
+    static bool insert(T*& root, T* node) { return Ops::insert(root, node); }
+    static T* unlink(T*& root, const Key& key) { return Ops::unlink(root, key); }
+    static T* build(T* const* sorted, size_t count) { return Ops::build(sorted, count); }
+
+    // Makes a node with the allocator and links it in, null (and nothing made) if the key is taken
+    template <typename... Args>
+    static T* emplace(T*& root, Args&&... args) {
+        T* node = Allocator::create(std::forward<Args>(args)...);
+        if (insert(root, node)) return node;
+        Allocator::destroy(node);
+        return nullptr;
+    }
+
+    // Takes the node out and gives it back to the allocator, false if there's none
+    static bool erase(T*& root, const Key& key) {
+        T* node = unlink(root, key);
+        if (!node) return false;
+        Allocator::destroy(node);
+        return true;
+    }
+
+    // In-order walk with its own stack instead of recursion, so a deep tree can't blow the
+    // call stack and the caller can stop at any point. Given a key range it only goes into
+    // subtrees that can hold keys in it, and stops after the last one.
+    class Iterator {
+    private:
+        std::vector<T*> path;
+        Key low, high;
+        bool bounded;
+
+        // Pushes the leftmost path that is still >= low. A node below low has nothing
+        // we want on its left, so we go right instead without stopping there.
+        void pushLeft(T* node) {
+            while (node) {
+                if (bounded && KeyOf::get(*node) < low) {
+                    node = Links::right(node);
+                } else {
+                    path.push_back(node);
+                    node = Links::left(node);
+                }
+            }
+        }
+
+    public:
+        explicit Iterator(T* root) : low(), high(), bounded(false) {
+            path.reserve(std::max<size_t>(Ops::depthHint(root) + 1, 1));
+            pushLeft(root);
+        }
+
+        Iterator(T* root, const Key& lowKey, const Key& highKey) : low(lowKey), high(highKey), bounded(true) {
+            path.reserve(std::max<size_t>(Ops::depthHint(root) + 1, 1));
+            pushLeft(root);
+        }
+
+        bool done() const { return path.empty() || (bounded && high < KeyOf::get(*path.back())); }
+        T* current() const { return path.back(); }
+
+        void next() {
+            T* node = path.back();
+            path.pop_back();
+            pushLeft(Links::right(node));
+        }
+    };
+
+    template <typename Visit>
+    static void forEach(T* root, Visit visit) {
+        for (Iterator it(root); !it.done(); it.next()) visit(it.current());
+    }
+};
+
+}  // namespace intrusive
+
+#endif
@@ -4,6 +4,15 @@ Author Notes:
 - The displayEventSchedule function's sorting implementation was adapted from a Claude AI example
   that helped me understand how to use std::sort with lambda functions to reduce code redundancy
 - Shout out to the C++ community on stackoverflow, even though they insulted me, they still helped with my bst implementation
+
+Build: g++ -std=c++17 -O2 -pthread ruth_olotu_question1.cpp -o ruth_olotu_question1
+Load benchmark: ./ruth_olotu_question1 --bench-load [number of events]
+Check-in queue benchmark: ./ruth_olotu_question1 --bench-checkin [check-ins per run]
+Operation benchmarks: ./ruth_olotu_question1 --bench [event counts...]   (default 10000 100000 1000000)
+Lookup by ID benchmark: ./ruth_olotu_question1 --bench-lookup [event counts...]   (same default)
+Concurrent store benchmark: ./ruth_olotu_question1 --bench-store [thread counts...]
+Replay a trace with no prompts: ./ruth_olotu_question1 --replay <trace file> [statistics json file]
+Write a generated trace: ./ruth_olotu_question1 --gen-trace <number of events> <trace file>
 */
 
 #include <iostream>
@@ -15,753 +24,5049 @@ Author Notes:
 #include <algorithm>
 #include <vector>
 #include <queue>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 #include <chrono>
 #include <ctime>
+#include <cstdint>
+#include <climits>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <string_view>
+#include <charconv>
+#include <random>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_MMAP 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+#include "intrusive_tree.h"
 using namespace std;
 
 //please note, majority of the syntax (not logic) for the the undo and redo stack operation was by claude ai, with minimal modififcations from my side.
 struct Attendee {
     string fullName;      
     string phoneNumber;  
-    Attendee* nextAttendee; 
     
    
-    Attendee(string name, string phone) : fullName(name), phoneNumber(phone), nextAttendee(nullptr) {}
+    Attendee(string name, string phone) : fullName(name), phoneNumber(phone) {}
 };
 
 struct CheckIn {
     int eventId;
     string attendeeName;
-    string timestamp;
+    int64_t timestamp;    // seconds since 1970, when they got to the desk
     
-    CheckIn(int id, string name, string time) 
+    CheckIn() : eventId(0), timestamp(0) {}
+    CheckIn(int id, string name, int64_t time) 
         : eventId(id), attendeeName(name), timestamp(time) {}
 };
 
+// There are only ever four event types, so a node keeps a one-byte category and the
+// text lives once in this table
+enum EventCategory : unsigned char { SEMINAR, SPORTS, COMPETITION, OTHERS, CATEGORY_COUNT };
+
+const char* const categoryNames[CATEGORY_COUNT] = {"seminar", "sports", "competition", "others"};
+
+// Trims and ignores case, false if the text isn't one of the four types
+bool parseCategory(string_view text, EventCategory& category) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == string_view::npos) return false;
+    text = text.substr(first, text.find_last_not_of(" \t\r") + 1 - first);
+    for (int c = 0; c < CATEGORY_COUNT; c++) {
+        string_view name = categoryNames[c];
+        if (name.size() != text.size()) continue;
+        bool same = true;
+        for (size_t i = 0; i < text.size() && same; i++) same = tolower((unsigned char)text[i]) == name[i];
+        if (same) {
+            category = (EventCategory)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Every distinct event name is stored once and events point at the shared copy. Counted, so
+// a name goes away with the last event using it. Locked because the loaders intern from
+// several threads at once.
+class NamePool {
+private:
+    unordered_map<string, uint32_t> names;   // name -> how many events use it
+    mutex lock;
+
+public:
+    const string* intern(string_view name) {
+        lock_guard<mutex> guard(lock);
+        auto entry = names.try_emplace(string(name), 0).first;
+        entry->second++;
+        return &entry->first;   // map nodes never move, so the pointer stays good
+    }
+
+    void release(const string* name) {
+        lock_guard<mutex> guard(lock);
+        auto entry = names.find(*name);
+        if (entry != names.end() && --entry->second == 0) names.erase(entry);
+    }
+
+    size_t size() {
+        lock_guard<mutex> guard(lock);
+        return names.size();
+    }
+
+    // Rough heap footprint: the map nodes plus any name too long for the small string buffer
+    size_t bytes() {
+        lock_guard<mutex> guard(lock);
+        size_t total = names.bucket_count() * sizeof(void*);
+        for (const auto& entry : names) {
+            total += sizeof(entry) + sizeof(void*) * 2;
+            if (entry.first.capacity() > 15) total += entry.first.capacity() + 1;
+        }
+        return total;
+    }
+};
+
+NamePool eventNames;
+
 struct EventNode {
+    // Everything a search, a rebalance or the schedule looks at comes first, in the first 40 bytes
     int eventId;             
-    string eventName;         
-    string eventType;     
     int importanceLevel;  //1-3 ;for 1-high, 2-medium, 3-low
-    
-    
-    Attendee* attendeeList;
-    Attendee* lastAttendee;
-    
-    
     EventNode* leftChild;         
     EventNode* rightChild;     
+    int height;           // AVL height of the subtree rooted here, a leaf is 1
+    EventCategory category;
+    const string* eventName;   // shared copy in eventNames
+
+    // Guards attendees and checkInLookup when EventStore calls run side by side. A real mutex
+    // rather than a spin: a registration holds it across its journal write, so the order of A
+    // records matches the list, and the desks waiting on it should sleep rather than spin.
+    mutex attendeeLock;
+ 
+    // Attendees live side by side in one block, in registration order
+    vector<Attendee> attendees;
+
+    // Hashed views of the attendees for check-in: normalized name -> how many registrations
+    // carry it, and the names that already came through the door. Only made once someone
+    // registers, most of a big catalog never needs them.
+    struct CheckInLookup {
+        unordered_map<string, int> registeredNames;
+        unordered_set<string> checkedInNames;
+    };
+    unique_ptr<CheckInLookup> checkInLookup;
+
+    EventNode(int id, string_view name, EventCategory type, int importance) 
+        : eventId(id), importanceLevel(importance), leftChild(nullptr), rightChild(nullptr), height(1),
+          category(type), eventName(eventNames.intern(name)) {}
+
+    ~EventNode() { eventNames.release(eventName); }
+
+    EventNode(const EventNode&) = delete;
+    EventNode& operator=(const EventNode&) = delete;
+
+    const string& name() const { return *eventName; }
+    const char* type() const { return categoryNames[category]; }
+
+    void rename(string_view newName) {
+        const string* old = eventName;
+        eventName = eventNames.intern(newName);
+        eventNames.release(old);
+    }
+};
+
+// Hands out objects from big slabs instead of one heap allocation per node.
+// Freed slots go on a free list and get reused, and destroyAll() tears the
+// whole pool down by sweeping the slabs front to back instead of walking trees.
+template <typename T>
+class SlabPool {
+private:
+    static const size_t SLAB_SIZE = 256;
+
+    struct Slot {
+        bool live;
+        union {
+            Slot* nextFree;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+    };
+
+    vector<Slot*> slabs;
+    Slot* freeList;
+    size_t usedInLastSlab;   // slots of the newest slab handed out at least once
+    size_t liveCount;
+    mutex createLock;        // only used by createConcurrent()
+
+    static T* objectIn(Slot* slot) { return reinterpret_cast<T*>(slot->storage); }
+
+    static Slot* slotOf(T* object) {
+        return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(object) - offsetof(Slot, storage));
+    }
+
+    Slot* takeSlot() {
+        if (freeList) {
+            Slot* slot = freeList;
+            freeList = slot->nextFree;
+            return slot;
+        }
+        if (slabs.empty() || usedInLastSlab == SLAB_SIZE) {
+            slabs.push_back(static_cast<Slot*>(::operator new(sizeof(Slot) * SLAB_SIZE)));
+            usedInLastSlab = 0;
+        }
+        return &slabs.back()[usedInLastSlab++];
+    }
+
+public:
+    SlabPool() : freeList(nullptr), usedInLastSlab(0), liveCount(0) {}
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool() {
+        destroyAll();
+        for (Slot* slab : slabs) ::operator delete(slab);
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = takeSlot();
+        T* object = new (slot->storage) T(std::forward<Args>(args)...);
+        slot->live = true;
+        liveCount++;
+        return object;
+    }
+
+    // Same as create() but safe to call from several threads at once (the parallel loaders).
+    // Only the slot is taken under the lock, the object is built outside it.
+    template <typename... Args>
+    T* createConcurrent(Args&&... args) {
+        Slot* slot;
+        {
+            lock_guard<mutex> lock(createLock);
+            slot = takeSlot();
+            liveCount++;
+        }
+        T* object = new (slot->storage) T(std::forward<Args>(args)...);
+        slot->live = true;
+        return object;
+    }
+
+    void destroy(T* object) {
+        if (!object) return;
+        Slot* slot = slotOf(object);
+        object->~T();
+        slot->live = false;
+        slot->nextFree = freeList;
+        freeList = slot;
+        liveCount--;
+    }
+
+    // Destroys every live object at once. The slabs are kept around for the next load.
+    void destroyAll() {
+        for (size_t s = 0; s < slabs.size(); s++) {
+            size_t used = (s + 1 == slabs.size()) ? usedInLastSlab : SLAB_SIZE;
+            for (size_t i = 0; i < used; i++) {
+                Slot& slot = slabs[s][i];
+                if (slot.live && !is_trivially_destructible<T>::value) objectIn(&slot)->~T();
+                slot.live = false;
+            }
+        }
+        // Everything is free again, hand the slabs out from the start
+        freeList = nullptr;
+        for (size_t s = slabs.size(); s-- > 0; ) {
+            size_t used = (s + 1 == slabs.size()) ? usedInLastSlab : SLAB_SIZE;
+            for (size_t i = used; i-- > 0; ) {
+                slabs[s][i].nextFree = freeList;
+                freeList = &slabs[s][i];
+            }
+        }
+        liveCount = 0;
+    }
+
+    size_t size() const { return liveCount; }
+
+    // Raw slots for classes that route their own operator new/delete through a pool.
+    // These are never marked live, so don't mix them with create()/destroyAll() on one pool.
+    void* allocateRaw() {
+        Slot* slot = takeSlot();
+        slot->live = false;
+        liveCount++;
+        return slot->storage;
+    }
 
-    EventNode(int id, string name, string type, int importance) 
-        : eventId(id), eventName(name), eventType(type), importanceLevel(importance),
-          attendeeList(nullptr), lastAttendee(nullptr), leftChild(nullptr), rightChild(nullptr) {}
+    void deallocateRaw(void* memory) {
+        Slot* slot = slotOf(static_cast<T*>(memory));
+        slot->nextFree = freeList;
+        freeList = slot;
+        liveCount--;
+    }
 };
 
+// All event nodes come out of this pool
+SlabPool<EventNode> eventPool;
+
+// Journal records write text as <length>:<bytes> so names with spaces or commas survive the round trip
+void writeJournalField(ostream& out, const string& text) {
+    out << ' ' << text.size() << ':' << text;
+}
+
+bool readJournalField(const string& line, size_t& pos, string& text) {
+    while (pos < line.size() && line[pos] == ' ') pos++;
+    size_t colon = line.find(':', pos);
+    if (colon == string::npos) return false;
+    // a torn or corrupt length just fails the record, it must not throw out of the replay
+    size_t length;
+    auto parsed = from_chars(line.data() + pos, line.data() + colon, length);
+    if (parsed.ec != errc() || parsed.ptr != line.data() + colon) return false;
+    if (length > line.size() - colon - 1) return false;
+    text = line.substr(colon + 1, length);
+    pos = colon + 1 + length;
+    return true;
+}
+
+// "A <id> <name> <phone>", shared by the undoable command and EventStore registrations
+void writeAttendeeRecord(ostream& out, int eventId, const Attendee& attendee) {
+    out << "A " << eventId;
+    writeJournalField(out, attendee.fullName);
+    writeJournalField(out, attendee.phoneNumber);
+    out << '\n';
+}
+
+// flush() only gets the bytes as far as the OS, a power cut can still lose them. These push them
+// to the disk: the data of a file, and the directory entry of a file that was just created or
+// renamed into place. Without POSIX there's nothing portable to call, so they do nothing there.
+bool syncFile(int fd) {
+#ifdef HAVE_MMAP
+    return fd < 0 || fsync(fd) == 0;
+#else
+    (void)fd;
+    return true;
+#endif
+}
+
+bool syncPath(const string& path, bool directory = false) {
+#ifdef HAVE_MMAP
+    int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = syncFile(fd);
+    ::close(fd);
+    return synced;
+#else
+    (void)path;
+    (void)directory;
+    return true;
+#endif
+}
+
+bool syncParentDirectory(const string& path) {
+    size_t slash = path.find_last_of('/');
+    return syncPath(slash == string::npos ? "." : path.substr(0, slash + 1), true);
+}
+
+// Names are matched trimmed and case-insensitive, the way staff type them at the door
+string normalizeName(string_view name) {
+    size_t first = name.find_first_not_of(" \t\r");
+    if (first == string_view::npos) return "";
+    name = name.substr(first, name.find_last_not_of(" \t\r") + 1 - first);
+    string normalized(name);
+    transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+    return normalized;
+}
+
+// Files a registration in the cross-event attendee index, or takes it out (defined with that index)
+// newerCount is how many of the event's attendees registered after the one being taken out
+void indexAttendee(const EventNode* event, const Attendee& attendee);
+void unindexAttendee(const EventNode* event, const Attendee& attendee, size_t newerCount);
+
+// Everything that registers or unregisters someone goes through these so the
+// name lookup used by check-in and the attendee index always match the attendee list
+void appendAttendee(EventNode* event, Attendee attendee) {
+    if (!event->checkInLookup) event->checkInLookup.reset(new EventNode::CheckInLookup());
+    event->checkInLookup->registeredNames[normalizeName(attendee.fullName)]++;
+    indexAttendee(event, attendee);
+    event->attendees.push_back(std::move(attendee));
+}
+
+// Almost always the last one, but front-desk clients may have registered others for the same event since
+Attendee removeAttendeeAt(EventNode* event, size_t position) {
+    Attendee removed = std::move(event->attendees[position]);
+    event->attendees.erase(event->attendees.begin() + position);
+    unindexAttendee(event, removed, event->attendees.size() - position);
+    unordered_map<string, int>& registeredNames = event->checkInLookup->registeredNames;
+    auto entry = registeredNames.find(normalizeName(removed.fullName));
+    if (entry != registeredNames.end() && --entry->second == 0) {
+        registeredNames.erase(entry);
+    }
+    return removed;
+}
+
+Attendee popLastAttendee(EventNode* event) {
+    return removeAttendeeAt(event, event->attendees.size() - 1);
+}
+
 class Command {
 public:
 //This abstract base class defines a contract that all commands must follow. 
 //It's a pure virtual class, so all commands (functions) 
 //in the system must be able to execute and undo itself.
     virtual void execute() = 0;
-    virtual void undo() = 0;
+    // False if it can't be undone any more (EventStore clients changed the attendee list under
+    // it), and then nothing was changed
+    virtual bool undo() = 0;
+    virtual bool canUndo() const { return true; }
+    // Writes one journal line describing what the last execute() or undo() just did
+    virtual void writeJournal(ostream& out) const = 0;
+    // Whether the command holds on to this event, so it can be dropped when the event goes away
+    virtual bool touches(const EventNode* event) const = 0;
     virtual ~Command() {}
 };
 
+// Gives a command class its own slab pool, so `new SomeCommand(...)` and `delete`
+// reuse slots instead of going to the heap for every single registration
+template <typename T>
+struct PoolAllocated {
+    static SlabPool<T>& commandPool() {
+        // never destroyed on purpose, commands can still be deleted by other globals at exit
+        static SlabPool<T>* pool = new SlabPool<T>();
+        return *pool;
+    }
+
+    static void* operator new(size_t size) {
+        return size == sizeof(T) ? commandPool().allocateRaw() : ::operator new(size);
+    }
+
+    static void operator delete(void* memory, size_t size) {
+        if (size == sizeof(T)) commandPool().deallocateRaw(memory);
+        else ::operator delete(memory);
+    }
+};
+
+// Changes an event's importance and moves it to the matching schedule bucket (defined with the schedule index)
+void setImportance(EventNode* event, int level);
+
+// Renames an event and refiles it in the name search index (defined with that index)
+void renameEvent(EventNode* event, string_view name);
+
+// Hands an event's new name, type and importance on to report snapshots (defined with them)
+void publishEvent(EventNode* event);
+
 // Command for updating event details
-class UpdateEventCommand : public Command {
+// Only the fields that change are stored, and each one holds whichever value is *not*
+// on the event right now. Execute and undo both just swap them. Type and importance swap in
+// place; a name change copies the current name out and interns the other one (and refiles the
+// event in the name index), so that part does allocate.
+class UpdateEventCommand : public Command, public PoolAllocated<UpdateEventCommand> {
 private:
     EventNode* event;
-    string oldName, newName;
-    string oldType, newType;
-    int oldImportance, newImportance;
+    string otherName;
+    EventCategory otherType;
+    int otherImportance;
     bool nameChanged, typeChanged, importanceChanged;
 
+    void swapFields() {
+        if (nameChanged) {
+            string current = event->name();
+            renameEvent(event, otherName);
+            otherName.swap(current);
+        }
+        if (typeChanged) swap(event->category, otherType);
+        if (importanceChanged) {
+            int current = event->importanceLevel;
+            setImportance(event, otherImportance);
+            otherImportance = current;
+        }
+        publishEvent(event);
+    }
+
 public:
-    UpdateEventCommand(EventNode* evt, 
-                      const string& nName, const string& nType, int nImportance)
+    // An empty name or a type that isn't one of the four leaves that field alone
+    UpdateEventCommand(EventNode* evt, string nName, const string& nType, int nImportance)
         : event(evt), 
-          oldName(evt->eventName), newName(nName),
-          oldType(evt->eventType), newType(nType),
-          oldImportance(evt->importanceLevel), newImportance(nImportance),
-          nameChanged(!nName.empty()),
-          typeChanged(!nType.empty()),
+          otherName(std::move(nName)),
+          otherType(OTHERS),
+          otherImportance(nImportance),
+          nameChanged(!otherName.empty()),
+          typeChanged(parseCategory(nType, otherType)),
           importanceChanged(nImportance >= 1 && nImportance <= 3) {}
 
-    void execute() override {
-        if (nameChanged) event->eventName = newName;
-        if (typeChanged) event->eventType = newType;
-        if (importanceChanged) event->importanceLevel = newImportance;
+    void execute() override { swapFields(); }
+    bool undo() override {
+        swapFields();
+        return true;
     }
+    bool touches(const EventNode* other) const override { return event == other; }
 
-    void undo() override {
-        if (nameChanged) event->eventName = oldName;
-        if (typeChanged) event->eventType = oldType;
-        if (importanceChanged) event->importanceLevel = oldImportance;
+    // Both directions just record the event's fields as they are now
+    void writeJournal(ostream& out) const override {
+        out << "U " << event->eventId << ' ' << event->importanceLevel;
+        writeJournalField(out, event->name());
+        writeJournalField(out, event->type());
+        out << '\n';
     }
 };
 
 // Command for adding attendee
-class AddAttendeeCommand : public Command {
+class AddAttendeeCommand : public Command, public PoolAllocated<AddAttendeeCommand> {
 private:
     EventNode* event;
-    Attendee* attendee;
+    Attendee attendee;   // held here while not executed, moved into the event while it is
+    size_t position;     // where it sits in the event's attendee list once executed
     bool isExecuted;
 
 public:
     AddAttendeeCommand(EventNode* evt, const string& name, const string& phone) 
-        : event(evt), isExecuted(false) {
-        attendee = new Attendee(name, phone);
+        : event(evt), attendee(name, phone), position(0), isExecuted(false) {}
+
+    void execute() override {
+        position = event->attendees.size();
+        appendAttendee(event, std::move(attendee));
+        isExecuted = true;
     }
 
-//The destructor ensures proper cleanup of the attendee object if the command was never executed.
-    ~AddAttendeeCommand() {
-        if (!isExecuted && attendee) {
-            delete attendee;
-        }
+    // Commands are undone in reverse order, so nothing before our attendee has moved. Only
+    // EventStore clients can have added people after it.
+    bool canUndo() const override { return isExecuted && position < event->attendees.size(); }
+
+    bool undo() override {
+        if (!canUndo()) return false;
+
+        attendee = removeAttendeeAt(event, position);
+        isExecuted = false;
+        return true;
     }
 
-    void execute() override {
-        if (!event->attendeeList) {
-            event->attendeeList = event->lastAttendee = attendee;
+    bool touches(const EventNode* other) const override { return event == other; }
+
+    void writeJournal(ostream& out) const override {
+        if (isExecuted) {
+            writeAttendeeRecord(out, event->eventId, event->attendees[position]);
         } else {
-            event->lastAttendee->nextAttendee = attendee;
-            event->lastAttendee = attendee;
+            out << "P " << event->eventId << ' ' << position << '\n';
         }
+    }
+};
+
+// Groups several commands into one history entry, e.g. a whole registration session.
+// Undo takes the steps back in reverse order.
+class MacroCommand : public Command, public PoolAllocated<MacroCommand> {
+private:
+    vector<Command*> steps;
+    bool isExecuted;
+
+public:
+    MacroCommand() : isExecuted(false) {}
+
+    ~MacroCommand() {
+        for (Command* step : steps) delete step;
+    }
+
+    // Adds a step that has already been executed on its own (the macro is being built up live)
+    void addExecuted(Command* step) {
+        steps.push_back(step);
         isExecuted = true;
     }
 
-    void undo() override {
-        if (!event->attendeeList) return;
+    bool empty() const { return steps.empty(); }
 
-        if (event->attendeeList == attendee) {
-            event->attendeeList = event->lastAttendee = nullptr;
-        } else {
-            Attendee* current = event->attendeeList;
-            while (current->nextAttendee != attendee) {
-                current = current->nextAttendee;
-            }
-            current->nextAttendee = nullptr;
-            event->lastAttendee = current;
+    void execute() override {
+        for (Command* step : steps) step->execute();
+        isExecuted = true;
+    }
+
+    // Every step is checked first, so the macro is undone whole or not at all
+    bool canUndo() const override {
+        for (Command* step : steps) {
+            if (!step->canUndo()) return false;
         }
+        return true;
+    }
+
+    bool undo() override {
+        if (!canUndo()) return false;
+        for (size_t i = steps.size(); i-- > 0; ) steps[i]->undo();
         isExecuted = false;
+        return true;
+    }
+
+    bool touches(const EventNode* event) const override {
+        for (Command* step : steps) {
+            if (step->touches(event)) return true;
+        }
+        return false;
+    }
+
+    // One journal line per step, in the order they were applied
+    void writeJournal(ostream& out) const override {
+        if (isExecuted) {
+            for (Command* step : steps) step->writeJournal(out);
+        } else {
+            for (size_t i = steps.size(); i-- > 0; ) steps[i]->writeJournal(out);
+        }
     }
 };
 
-// Command manager to handle undo/redo operations
-//The CommandManager is like a history keeper. It maintains two stacks:
-//The undo stack records all commands as they're executed
-//The redo stack stores commands that were undone
+// A whole registration spreadsheet as one history entry. The rows come grouped by event, so
+// each event's list is grown once and the journal gets everything in one write.
+struct ImportGroup {
+    EventNode* event;
+    vector<Attendee> attendees;   // held here while not executed, moved into the event while it is
+    size_t position;              // where the first of them sits in the event's list once executed
+};
 
-class CommandManager {
+class ImportAttendeesCommand : public Command, public PoolAllocated<ImportAttendeesCommand> {
 private:
-    stack<Command*> undoStack;
-    stack<Command*> redoStack;
+    vector<ImportGroup> groups;
+    bool isExecuted;
 
 public:
-    ~CommandManager() {
-        while (!undoStack.empty()) {
-            delete undoStack.top();
-            undoStack.pop();
+    explicit ImportAttendeesCommand(vector<ImportGroup> imported) : groups(std::move(imported)), isExecuted(false) {}
+
+    void execute() override {
+        for (ImportGroup& group : groups) {
+            vector<Attendee>& attendees = group.event->attendees;
+            group.position = attendees.size();
+            attendees.reserve(attendees.size() + group.attendees.size());
+            for (Attendee& attendee : group.attendees) appendAttendee(group.event, std::move(attendee));
         }
-        while (!redoStack.empty()) {
-            delete redoStack.top();
-            redoStack.pop();
+        isExecuted = true;
+    }
+
+    // Every group is checked before any is taken out, so if one list has shrunk under us the
+    // whole import stays in and stays executed
+    bool canUndo() const override {
+        if (!isExecuted) return false;
+        for (const ImportGroup& group : groups) {
+            if (group.position + group.attendees.size() > group.event->attendees.size()) return false;
         }
+        return true;
     }
 
-    void executeCommand(Command* command) {
-        command->execute();
-        undoStack.push(command);
-        
-        // Clear redo stack
-        while (!redoStack.empty()) {
-            delete redoStack.top();
-            redoStack.pop();
+    // Last in, first out, like AddAttendeeCommand
+    bool undo() override {
+        if (!canUndo()) return false;
+        for (size_t g = groups.size(); g-- > 0; ) {
+            ImportGroup& group = groups[g];
+            for (size_t i = group.attendees.size(); i-- > 0; ) {
+                group.attendees[i] = removeAttendeeAt(group.event, group.position + i);
+            }
         }
+        isExecuted = false;
+        return true;
     }
 
-    bool canUndo() { return !undoStack.empty(); }
-    bool canRedo() { return !redoStack.empty(); }
+    bool touches(const EventNode* event) const override {
+        for (const ImportGroup& group : groups) {
+            if (group.event == event) return true;
+        }
+        return false;
+    }
 
-    void undo() {
-        if (!canUndo()) {
-            cout << "Nothing to undo!" << endl;
+    // One line per attendee, the same records a registration session would write
+    void writeJournal(ostream& out) const override {
+        if (isExecuted) {
+            for (const ImportGroup& group : groups) {
+                for (size_t i = 0; i < group.attendees.size(); i++) {
+                    writeAttendeeRecord(out, group.event->eventId, group.event->attendees[group.position + i]);
+                }
+            }
             return;
         }
+        for (size_t g = groups.size(); g-- > 0; ) {
+            for (size_t i = groups[g].attendees.size(); i-- > 0; ) {
+                out << "P " << groups[g].event->eventId << ' ' << groups[g].position + i << '\n';
+            }
+        }
+    }
+};
+
+// ===== Instrumentation =====
+// Per-operation counters and latency histograms, plus a few structural counters.
+// Everything is a relaxed atomic so the snapshot writer thread can record too. When it's
+// switched off every hook costs one load of a bool and a branch.
+// Latency buckets are powers of two: bucket b counts samples in [2^(b-1), 2^b) nanoseconds.
+
+enum StatOp { STAT_CREATE, STAT_FIND, STAT_UPDATE, STAT_REMOVE, STAT_REGISTER, STAT_CHECKIN, STAT_PROCESS,
+              STAT_UNDO, STAT_REDO, STAT_SCHEDULE, STAT_REPORT, STAT_LOAD_EVENTS, STAT_LOAD_ATTENDEES,
+              STAT_SAVE, STAT_RANGE, STAT_SEARCH, STAT_LOOKUP, STAT_HISTORY, STAT_IMPORT, STAT_OP_COUNT };
+
+const char* statOpNames[STAT_OP_COUNT] = {"create", "find", "update", "remove", "register", "checkin", "process",
+                                          "undo", "redo", "schedule", "report", "load_events", "load_attendees",
+                                          "save", "range", "search", "lookup", "history", "import"};
+
+inline int bitWidth(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return value ? 64 - __builtin_clzll(value) : 0;
+#else
+    int width = 0;
+    while (value) { width++; value >>= 1; }
+    return width;
+#endif
+}
+
+struct LatencyHistogram {
+    static const int BUCKETS = 40;   // the last one catches everything over ~4.5 minutes
+    atomic<uint64_t> buckets[BUCKETS] = {};
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> totalNs{0};
+    atomic<uint64_t> maxNs{0};
 
-        Command* command = undoStack.top();
-        undoStack.pop();
-        command->undo();
-        redoStack.push(command);
+    void record(uint64_t ns) {
+        buckets[min(bitWidth(ns), BUCKETS - 1)].fetch_add(1, memory_order_relaxed);
+        count.fetch_add(1, memory_order_relaxed);
+        totalNs.fetch_add(ns, memory_order_relaxed);
+        uint64_t seen = maxNs.load(memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, memory_order_relaxed)) {}
     }
 
-    void redo() {
-        if (!canRedo()) {
-            cout << "Nothing to redo!" << endl;
-            return;
+    // Upper edge of the bucket the given fraction of samples falls in (capped at the max seen),
+    // so within 2x of the real value
+    uint64_t percentileNs(double fraction) const {
+        uint64_t total = count.load(memory_order_relaxed);
+        uint64_t largest = maxNs.load(memory_order_relaxed);
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)(fraction * (total - 1)) + 1, seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += buckets[b].load(memory_order_relaxed);
+            if (seen >= rank) return b == 0 ? 0 : min((uint64_t)1 << b, largest);
         }
-
-        Command* command = redoStack.top();
-        redoStack.pop();
-        command->execute();
-        undoStack.push(command);
+        return largest;
     }
 };
 
-// Global command manager instance
-CommandManager commandManager;
+struct Instrumentation {
+    atomic<bool> enabled{true};
+    LatencyHistogram latency[STAT_OP_COUNT];
+    atomic<uint64_t> failures[STAT_OP_COUNT] = {};
 
-queue<CheckIn> checkInQueue;
-priority_queue<pair<int, EventNode*>> eventPriorityQueue;
+    // how deep findEvent has to go into a category tree
+    static const int MAX_DEPTH = 64;
+    atomic<uint64_t> searchDepths[MAX_DEPTH] = {};
+    atomic<uint64_t> searches{0};
+    atomic<uint64_t> searchNodesVisited{0};
 
+    atomic<uint64_t> bytesWritten{0};        // everything written through writeFileAtomically
+    atomic<uint64_t> lastSnapshotBytes{0};   // both files of the last snapshot
+    atomic<uint64_t> journalRecords{0};
+    atomic<uint64_t> queueHighWater{0};
 
-void saveEventToFile(ofstream &outFile, EventNode* root) {
-    if (root != nullptr) {
-        outFile << root->eventId << ", " << root->eventName << ", " 
-                << root->eventType << ", " << root->importanceLevel << "\n";
-        saveEventToFile(outFile, root->leftChild);
-        saveEventToFile(outFile, root->rightChild);
-    }
-}
+    bool on() const { return enabled.load(memory_order_relaxed); }
 
-// Saves all our events to disk for data persisitence
-void saveAllEvents(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
-    ofstream outFile("events.txt", ios::trunc); 
-    if (!outFile.is_open()) {
-        cout << "Oops! Couldn't open the events file for saving. Check permissions." << endl;
-        return;
+    void recordSearch(int depth) {
+        if (!on()) return;
+        searchDepths[min(depth, MAX_DEPTH - 1)].fetch_add(1, memory_order_relaxed);
+        searches.fetch_add(1, memory_order_relaxed);
+        searchNodesVisited.fetch_add((uint64_t)depth, memory_order_relaxed);
     }
-    saveEventToFile(outFile, seminars);
-    saveEventToFile(outFile, sports);
-    saveEventToFile(outFile, competitions);
-    saveEventToFile(outFile, others);
-    outFile.close();
-}
 
+    void add(atomic<uint64_t>& counter, uint64_t amount) {
+        if (on()) counter.fetch_add(amount, memory_order_relaxed);
+    }
 
-//loads all prewritten data when the code is actually running, and inserts each node into a single BST
-EventNode* loadEventFromFile(ifstream &inFile) {
-    string line;
-    EventNode* root = nullptr;
+    void raiseTo(atomic<uint64_t>& gauge, uint64_t value) {
+        if (!on()) return;
+        uint64_t seen = gauge.load(memory_order_relaxed);
+        while (value > seen && !gauge.compare_exchange_weak(seen, value, memory_order_relaxed)) {}
+    }
+};
 
-    while (getline(inFile, line)) {
-        stringstream ss(line);
-        int eventId, importanceLevel;
-        string eventName, eventType;
+Instrumentation instrumentation;
 
-        
-        getline(ss, eventName, ',');
-        getline(ss, eventType, ',');
-        ss >> importanceLevel;
-        ss>> eventId;
+// Times one operation from construction to the end of the scope. Call failed() if it didn't go through.
+class OpTimer {
+private:
+    StatOp op;
+    bool active;
+    chrono::steady_clock::time_point start;
 
-        EventNode* newEvent = new EventNode(eventId, eventName, eventType, importanceLevel);
-        insertEvent(root, newEvent); 
+public:
+    explicit OpTimer(StatOp timedOp) : op(timedOp), active(instrumentation.on()) {
+        if (active) start = chrono::steady_clock::now();
     }
 
-    return root;
-}
+    OpTimer(const OpTimer&) = delete;
+    OpTimer& operator=(const OpTimer&) = delete;
 
-//this then breaks down the single BST into the 4 individual BSTs for each event category
-void loadAllEvents(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
-    ifstream inFile("events.txt");
-    if (!inFile.is_open()) {
-        cout << "Couldn't open the events file. Starting with an empty database." << endl;
-        return;
+    void failed() {
+        if (active) instrumentation.failures[op].fetch_add(1, memory_order_relaxed);
     }
 
-    // Load events into appropriate trees
-    seminars = loadEventFromFile(inFile);
-    sports = loadEventFromFile(inFile);
-    competitions = loadEventFromFile(inFile);
-    others = loadEventFromFile(inFile);
+    ~OpTimer() {
+        if (!active) return;
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        instrumentation.latency[op].record((uint64_t)elapsed.count());
+    }
+};
 
-    inFile.close();
-}
+// Write-ahead journal. Instead of rewriting events.txt and attendees.txt after
+// every change, each mutation appends one short line here. At startup the
+// journal is replayed on top of the snapshot files. The background snapshot
+// writer folds it back into them: it rotates the journal to <file>.old when it
+// takes a snapshot and deletes that once the snapshot is safely on disk.
+//
+// Every line starts with a sequence number, and each data file's header says the last one
+// it already holds, so replaying records a snapshot already contains (after a crash before
+// <file>.old was deleted) skips them instead of applying them twice. Lines without a number
+// come from older journals and are always applied.
+//
+// Record types:
+//   C <id> <importance> <type> <name>   event created
+//   R <id> <tree>                       event removed from that category's tree
+//   U <id> <importance> <name> <type>   event fields after an update or its undo
+//   A <id> <name> <phone>               attendee appended
+//   P <id>                              last attendee popped (undo of A)
+// Tells the background snapshot writer there is something new to save (defined with it)
+void markStateDirty();
 
-// Saves participant info to keep track of who's coming!
-void saveAttendeeInfo(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
-    ofstream outFile("attendees.txt", ios::trunc);
-    if (!outFile) {
-        cout << "Hey, couldn't open the attendees file. Something's not right." << endl;
-        return;
+class EventJournal {
+private:
+    string path;
+    ofstream out;
+    int syncFd;        // our own descriptor on the journal, ofstream doesn't hand its one out
+    mutex writeLock;   // EventStore clients append records from several threads
+    atomic<uint64_t> lastWritten;   // sequence number of the newest record
+
+    void commit() {
+        out.flush();           // one small write per mutation,
+        syncFile(syncFd);      // on disk before the menu comes back
+        instrumentation.add(instrumentation.journalRecords, 1);
+        markStateDirty();
     }
 
-    function<void(EventNode*)> saveEventAttendees = [&outFile, &saveEventAttendees](EventNode* event) {
-        if (!event) return;
+    // Writes the records (one per line) with the next sequence numbers in front, then commits
+    void append(const string& records) {
+        for (size_t start = 0; start < records.size(); ) {
+            size_t end = records.find('\n', start);
+            end = end == string::npos ? records.size() : end + 1;
+            out << lastWritten + 1 << ' ';
+            out.write(records.data() + start, (streamsize)(end - start));
+            lastWritten++;
+            start = end;
+        }
+        commit();
+    }
 
-        saveEventAttendees(event->leftChild);
+    void openFile(ios::openmode mode) {
+        out.open(path, mode);
+        if (!out.is_open()) return;
+#ifdef HAVE_MMAP
+        syncFd = ::open(path.c_str(), O_RDONLY);
+#endif
+        syncParentDirectory(path);   // the journal may have just been created
+    }
 
-        // Write event details first
-        outFile << event->eventId << "," << event->eventType << "," << event->eventName << "\n";
+    void closeFile() {
+        out.close();
+#ifdef HAVE_MMAP
+        if (syncFd >= 0) ::close(syncFd);
+#endif
+        syncFd = -1;
+    }
 
-        // Then write all attendee info
-        Attendee* current = event->attendeeList;
-        while (current) {
-            outFile << current->fullName << "," << current->phoneNumber << "\n";
-            current = current->nextAttendee;
+public:
+    explicit EventJournal(const string& file) : path(file), syncFd(-1), lastWritten(0) {}
+    ~EventJournal() { closeFile(); }
+
+    void open() {
+        openFile(ios::app);
+        if (!out.is_open()) {
+            cout << "Couldn't open the journal, changes will only be saved on exit." << endl;
         }
-        outFile << "#\n"; // Our trusty event separator
+    }
 
-        saveEventAttendees(event->rightChild);
-    };
+    void recordCommand(const Command& command) {
+        lock_guard<mutex> guard(writeLock);
+        if (!out.is_open()) return;
+        ostringstream records;
+        command.writeJournal(records);
+        append(records.str());
+    }
 
-    saveEventAttendees(seminars);
-    saveEventAttendees(sports);
-    saveEventAttendees(competitions);
-    saveEventAttendees(others);
-    outFile.close();
-}
+    void recordAttendee(int eventId, const Attendee& attendee) {
+        lock_guard<mutex> guard(writeLock);
+        if (!out.is_open()) return;
+        ostringstream record;
+        writeAttendeeRecord(record, eventId, attendee);
+        append(record.str());
+    }
 
-//loads all prewritten data when the code is actually running
-void loadAttendeeInfo(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
-    ifstream inFile("attendees.txt");
-    if (!inFile.is_open()) {
-        cout << "Couldn't open the attendees file. No attendee data loaded." << endl;
-        return;
+    void recordCreate(const EventNode* event) {
+        lock_guard<mutex> guard(writeLock);
+        if (!out.is_open()) return;
+        ostringstream record;
+        record << "C " << event->eventId << ' ' << event->importanceLevel;
+        writeJournalField(record, event->type());
+        writeJournalField(record, event->name());
+        record << '\n';
+        append(record.str());
     }
 
-    string line;
-    while (getline(inFile, line)) {
-        if (line == "#") continue; // Skip event separator
+    void recordRemove(const string& tree, int eventId) {
+        lock_guard<mutex> guard(writeLock);
+        if (!out.is_open()) return;
+        ostringstream record;
+        record << "R " << eventId;
+        writeJournalField(record, tree);
+        record << '\n';
+        append(record.str());
+    }
 
-        stringstream ss(line);
-        int eventId;
-        string eventType, eventName;
+    // Numbering carries on after the highest number the data files or the journal files used
+    void noteSequence(uint64_t sequence) {
+        if (sequence > lastWritten) lastWritten = sequence;
+    }
+
+    uint64_t lastSequence() const { return lastWritten; }
+
+    // Moves everything journaled so far to <file>.old and starts an empty journal.
+    // Done together with taking a snapshot, so .old holds exactly what the snapshot covers
+    // (plus the leftovers of any earlier snapshot that failed to write).
+    void rotate() {
+        bool wasOpen = out.is_open();
+        closeFile();
+        string oldPath = path + ".old";
+        ifstream existingOld(oldPath);
+        if (!existingOld.is_open()) {
+            rename(path.c_str(), oldPath.c_str());
+        } else {
+            existingOld.close();
+            ifstream current(path, ios::binary);
+            ofstream old(oldPath, ios::binary | ios::app);
+            if (current.is_open() && current.peek() != EOF) old << current.rdbuf();
+            old.close();
+            syncPath(oldPath);
+        }
+        syncParentDirectory(oldPath);
+        if (wasOpen) openFile(ios::trunc);
+    }
+
+    // The snapshot that went with the last rotate() is on disk, the old records aren't needed
+    void dropRotated() {
+        remove((path + ".old").c_str());
+    }
+
+    const string& fileName() const { return path; }
+};
+
+EventJournal eventJournal("events.journal");
 
-        // Read event details
-        ss >> eventId >> eventType >> eventName;
+// Background persistence. Changes only mark the state dirty; a writer thread then
+// takes a consistent snapshot (serialized in memory while holding the state lock),
+// lets go of the lock, and writes it to temp files that are renamed into place.
+// Any number of changes made while it waits or writes collapse into the next write.
+// The menu holds stateMutex() while an action reads or changes the catalog (never while it
+// waits for the operator to type), so the writer never sees a half-applied change. EventStore calls hold it shared, so they run side by side
+// but never while the menu or the writer has the whole catalog.
+class SnapshotWriter {
+private:
+    shared_mutex state;         // guards the trees against the writer's snapshot
+    mutex signal;               // guards the fields below
+    condition_variable wakeUp;
+    bool dirty;
+    bool flushing;
+    bool stopping;
+    unsigned long requested;    // bumped by every markDirty()
+    unsigned long written;      // the last request number a write attempt covered
+    unsigned long snapshotsWritten;
+    unsigned long snapshotsFailed;
+    thread worker;
+    function<bool()> takeAndWrite;
 
-        EventNode* event = nullptr;
+    static constexpr chrono::milliseconds SETTLE_TIME{200};
 
-        // Find the corresponding event in the correct tree
-        if (eventType == "Seminar") event = findEvent(seminars, eventId);
-        else if (eventType == "Sports") event = findEvent(sports, eventId);
-        else if (eventType == "Competition") event = findEvent(competitions, eventId);
-        else if (eventType == "Others") event = findEvent(others, eventId);
+    void run() {
+        unique_lock<mutex> lock(signal);
+        for (;;) {
+            wakeUp.wait(lock, [this] { return dirty || stopping; });
+            if (!dirty) break;   // stopping with nothing left to save
 
-        if (!event) continue; // Skip if event is not found
+            // let a burst of changes settle so they go out as one write
+            if (!flushing && !stopping) {
+                wakeUp.wait_for(lock, SETTLE_TIME, [this] { return flushing || stopping; });
+            }
+            dirty = false;
+            unsigned long covering = requested;
+            lock.unlock();
 
-        // Read attendees for this event
-        while (getline(inFile, line) && line != "#") {
-            string attendeeName, phoneNumber;
-            stringstream attendeeStream(line);
-            getline(attendeeStream, attendeeName, ',');
-            getline(attendeeStream, phoneNumber, ',');
+            bool ok = takeAndWrite();
 
-            // Add attendee to the event
-            Attendee* newAttendee = new Attendee(attendeeName, phoneNumber);
-            newAttendee->nextAttendee = event->attendeeList;
-            event->attendeeList = newAttendee;
+            lock.lock();
+            if (ok) snapshotsWritten++;
+            else snapshotsFailed++;
+            written = covering;
+            wakeUp.notify_all();
         }
     }
 
-    inFile.close();
-}
+public:
+    SnapshotWriter() : dirty(false), flushing(false), stopping(false), requested(0), written(0),
+                       snapshotsWritten(0), snapshotsFailed(0) {}
 
+    ~SnapshotWriter() { shutdown(); }
 
-EventNode* findMinNode(EventNode* node) {
-    while (node && node->leftChild) {
-        node = node->leftChild;
-    }
-    return node;
-}
+    shared_mutex& stateMutex() { return state; }
 
-// Basic search function with some assistance from chatgpt
-EventNode* findEvent(EventNode* root, int targetId) {
-    while (root && root->eventId != targetId) {
-        root = (targetId < root->eventId) ? root->leftChild : root->rightChild;
+    // snapshotAndWrite is called on the writer thread, it must lock stateMutex() while it reads the trees
+    void start(function<bool()> snapshotAndWrite) {
+        takeAndWrite = std::move(snapshotAndWrite);
+        worker = thread(&SnapshotWriter::run, this);
     }
-    return root; // Either the found node or nullptr
-}
 
-/*I hardcoded event types, because ideally, the application would have a 
-dropdown box of all the type of events available to register, there is the "Other"
-available sha, just in case, but i cannot kill myself.
+    void markDirty() {
+        lock_guard<mutex> lock(signal);
+        if (!worker.joinable()) return;
+        requested++;
+        dirty = true;
+        wakeUp.notify_all();
+    }
 
-*/
-void insertEvent(EventNode*& root, EventNode* newEvent) { 
-    if (!root) {
-        root = newEvent;
-        return;
+    // Blocks until everything marked dirty before this call has been written (or failed to)
+    void flush() {
+        unique_lock<mutex> lock(signal);
+        if (!worker.joinable()) return;
+        if (!dirty && written == requested) return;
+        unsigned long target = requested;
+        flushing = true;
+        wakeUp.notify_all();
+        wakeUp.wait(lock, [this, target] { return written >= target; });
+        flushing = false;
     }
-    if (newEvent->eventId < root->eventId) {
-        insertEvent(root->leftChild, newEvent);
-    } else {
-        insertEvent(root->rightChild, newEvent);
+
+    // Flush-on-exit barrier: writes whatever is pending, then stops the thread
+    void shutdown() {
+        flush();
+        {
+            lock_guard<mutex> lock(signal);
+            stopping = true;
+            wakeUp.notify_all();
+        }
+        if (worker.joinable()) worker.join();
     }
 
-    
-}
+    bool pending() {
+        lock_guard<mutex> lock(signal);
+        return dirty || written != requested;
+    }
 
-// chatgpt helped me here to ensure that even when i was removing events, my BST would still be balanced
-EventNode* removeEvent(EventNode* root, int targetId) {
-    if (!root) {
-        cout << "Hmm, couldn't find that event. Maybe it was already deleted?" << endl;
-        return nullptr;
+    unsigned long writtenCount() {
+        lock_guard<mutex> lock(signal);
+        return snapshotsWritten;
     }
 
-    if (targetId < root->eventId) {
-        root->leftChild = removeEvent(root->leftChild, targetId);
-    } else if (targetId > root->eventId) {
-        root->rightChild = removeEvent(root->rightChild, targetId);
+    unsigned long failedCount() {
+        lock_guard<mutex> lock(signal);
+        return snapshotsFailed;
+    }
+};
+
+SnapshotWriter snapshotWriter;
+
+void markStateDirty() {
+    snapshotWriter.markDirty();
+}
+
+// Command manager to handle undo/redo operations
+//The CommandManager is like a history keeper. It keeps the last `depth` commands in a
+//ring buffer: the first undoCount entries (from oldest) can be undone, the redoCount
+//entries after them are ones that were undone and can be redone. When the ring is
+//full the oldest command is dropped, so a long session can't grow memory forever.
+
+class CommandManager {
+private:
+    vector<Command*> history;
+    size_t oldest;
+    size_t undoCount;
+    size_t redoCount;
+
+    Command*& slot(size_t offset) { return history[(oldest + offset) % history.size()]; }
+
+    void dropRedo() {
+        while (redoCount > 0) {
+            delete slot(undoCount + redoCount - 1);
+            redoCount--;
+        }
+    }
+
+    void push(Command* command) {
+        dropRedo();
+        if (undoCount == history.size()) {
+            delete slot(0);   // forget the oldest one
+            oldest = (oldest + 1) % history.size();
+            undoCount--;
+        }
+        slot(undoCount) = command;
+        undoCount++;
+    }
+
+public:
+    explicit CommandManager(size_t depth) : history(max(depth, (size_t)1), nullptr), oldest(0), undoCount(0), redoCount(0) {}
+
+    ~CommandManager() {
+        clear();
+    }
+
+    // An event is being removed: drops every command that still points at it, since its pool
+    // slot gets reused by the next create. The rest of the history stays undoable in the same order.
+    void forgetEvent(const EventNode* event) {
+        vector<Command*> kept;
+        size_t keptUndo = 0;
+        for (size_t i = 0; i < undoCount + redoCount; i++) {
+            Command* command = slot(i);
+            if (command->touches(event)) {
+                delete command;
+                continue;
+            }
+            if (i < undoCount) keptUndo++;
+            kept.push_back(command);
+        }
+        copy(kept.begin(), kept.end(), history.begin());
+        oldest = 0;
+        undoCount = keptUndo;
+        redoCount = kept.size() - keptUndo;
+    }
+
+    // Drops the whole history, needed before the event pools are torn down for a reload
+    void clear() {
+        dropRedo();
+        while (undoCount > 0) {
+            delete slot(undoCount - 1);
+            undoCount--;
+        }
+        oldest = 0;
+    }
+
+    void executeCommand(Command* command) {
+        command->execute();
+        eventJournal.recordCommand(*command);
+        push(command);
+    }
+
+    // For commands that were applied step by step already (like a registration session's
+    // MacroCommand): journals the whole thing in one write and makes it undoable as one unit
+    void commitExecuted(Command* command) {
+        eventJournal.recordCommand(*command);
+        push(command);
+    }
+
+    bool canUndo() { return undoCount > 0; }
+    bool canRedo() { return redoCount > 0; }
+
+    // Both return false when there was nothing to do. Undo also does when the command refused
+    // (canUndo() is still true then), it stays where it is and nothing is journaled.
+    bool undo() {
+        if (!canUndo()) return false;
+
+        Command* command = slot(undoCount - 1);
+        if (!command->undo()) return false;
+        eventJournal.recordCommand(*command);
+        undoCount--;
+        redoCount++;
+        return true;
+    }
+
+    bool redo() {
+        if (!canRedo()) return false;
+
+        Command* command = slot(undoCount);
+        command->execute();
+        eventJournal.recordCommand(*command);
+        undoCount++;
+        redoCount--;
+        return true;
+    }
+};
+
+// Global command manager instance, remembers the last HISTORY_DEPTH operations
+const size_t HISTORY_DEPTH = 256;
+CommandManager commandManager(HISTORY_DEPTH);
+
+// One hash index from eventId to its node across all four category trees.
+// Open addressing with linear probing, so a lookup is a couple of array probes
+// no matter how many categories there are or what shape the trees are in.
+class EventIndex {
+private:
+    enum SlotState : unsigned char { EMPTY, FULL, DELETED };
+
+    struct Slot {
+        int eventId;
+        SlotState state;
+        EventNode* event;
+    };
+
+    vector<Slot> slots;   // size is always a power of two
+    size_t liveCount;
+    size_t usedCount;     // live + deleted, deleted slots still lengthen probe chains
+
+    size_t slotFor(int eventId) const {
+        // fibonacci hashing spreads sequential IDs across the table
+        return (size_t)((uint32_t)eventId * 2654435769u) & (slots.size() - 1);
+    }
+
+    void rehash(size_t newSize) {
+        vector<Slot> oldSlots;
+        oldSlots.swap(slots);
+        slots.assign(newSize, Slot{0, EMPTY, nullptr});
+        liveCount = usedCount = 0;
+        for (const Slot& slot : oldSlots) {
+            if (slot.state == FULL) insert(slot.event);
+        }
+    }
+
+    void grow() {
+        size_t newSize = slots.empty() ? 16 : slots.size();
+        // only double when it's actually full of live entries, otherwise rehashing clears the tombstones
+        if (liveCount * 2 >= newSize) newSize *= 2;
+        rehash(newSize);
+    }
+
+public:
+    EventIndex() : liveCount(0), usedCount(0) {}
+
+    // Returns false (and leaves the table alone) if the ID is already taken
+    bool insert(EventNode* event) {
+        if ((usedCount + 1) * 10 > slots.size() * 7) grow();
+
+        size_t mask = slots.size() - 1;
+        size_t reuse = slots.size();
+        for (size_t i = slotFor(event->eventId); ; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.state == EMPTY) {
+                if (reuse == slots.size()) {
+                    reuse = i;
+                    usedCount++;
+                }
+                break;
+            }
+            if (slot.state == DELETED) {
+                if (reuse == slots.size()) reuse = i;
+            } else if (slot.eventId == event->eventId) {
+                return false;
+            }
+        }
+        slots[reuse] = Slot{event->eventId, FULL, event};
+        liveCount++;
+        return true;
+    }
+
+    EventNode* find(int eventId) const {
+        if (slots.empty()) return nullptr;
+        size_t mask = slots.size() - 1;
+        for (size_t i = slotFor(eventId); slots[i].state != EMPTY; i = (i + 1) & mask) {
+            if (slots[i].state == FULL && slots[i].eventId == eventId) return slots[i].event;
+        }
+        return nullptr;
+    }
+
+    bool erase(int eventId) {
+        if (slots.empty()) return false;
+        size_t mask = slots.size() - 1;
+        for (size_t i = slotFor(eventId); slots[i].state != EMPTY; i = (i + 1) & mask) {
+            if (slots[i].state == FULL && slots[i].eventId == eventId) {
+                slots[i].state = DELETED;
+                slots[i].event = nullptr;
+                liveCount--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() {
+        slots.clear();
+        liveCount = usedCount = 0;
+    }
+
+    // Sizes the table up front for a bulk load so it isn't rehashed over and over
+    void reserve(size_t expected) {
+        size_t wanted = 16;
+        while (wanted * 7 < expected * 10) wanted *= 2;
+        if (wanted > slots.size()) rehash(wanted);
+    }
+
+    size_t size() const { return liveCount; }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (const Slot& slot : slots) {
+            if (slot.state == FULL) visit(slot.event);
+        }
+    }
+};
+
+EventIndex eventIndex;
+
+// Read-mostly lookups by ID, many at a time. The hash index answers one ID in a couple of probes
+// but every answer is a miss into a scattered EventNode; this one is built for batches.
+// It's a static B-tree over every event ID in sorted order, 16 keys to a node so a node is one
+// 64-byte cache line, with all nodes in one array: node k's children are k*17+1 ... k*17+17, so
+// there are no child pointers to chase. The 16 keys of a node are compared with the target all
+// at once with SSE2 or NEON (a plain loop anywhere else). A batch walks a group of IDs down the
+// tree level by level and prefetches each one's next node, so their cache misses overlap.
+// Creates and removes only mark it stale, it's rebuilt by the next lookup. Like the hash index
+// it's only used with the state lock held, never from EventStore calls.
+class FrozenIdIndex {
+private:
+    static constexpr int KEYS = 16;
+    static constexpr size_t GROUP = 16;   // lookups in flight at once in a batch
+
+    struct alignas(64) Node {
+        int32_t keys[KEYS];
+    };
+
+    vector<Node> nodes;
+    vector<EventNode*> events;   // events[k * KEYS + i] goes with nodes[k].keys[i], null for padding
+    int depth;
+    bool stale;
+
+    static size_t child(size_t k, int i) { return k * (KEYS + 1) + i + 1; }
+
+    // Hands the sorted events out in order: subtree 0, key 0, subtree 1, key 1, ... key 15, subtree 16.
+    // Slots left over at the end are padded with INT_MAX and no event.
+    void place(size_t k, const vector<pair<int, EventNode*>>& sorted, size_t& next) {
+        if (k >= nodes.size()) return;
+        for (int i = 0; i < KEYS; i++) {
+            place(child(k, i), sorted, next);
+            bool real = next < sorted.size();
+            nodes[k].keys[i] = real ? sorted[next].first : INT_MAX;
+            events[k * KEYS + i] = real ? sorted[next++].second : nullptr;
+        }
+        place(child(k, KEYS), sorted, next);
+    }
+
+    void rebuild() {
+        // sorting (ID, node) pairs keeps the sort from reading every node over and over
+        vector<pair<int, EventNode*>> sorted;
+        sorted.reserve(eventIndex.size());
+        eventIndex.forEach([&sorted](EventNode* event) { sorted.emplace_back(event->eventId, event); });
+        sort(sorted.begin(), sorted.end());
+
+        nodes.assign((sorted.size() + KEYS - 1) / KEYS, Node());
+        events.assign(nodes.size() * KEYS, nullptr);
+        size_t next = 0;
+        place(0, sorted, next);
+
+        // levels of a complete 17-way tree it takes to hold every node
+        depth = 0;
+        for (size_t levelStart = 0, levelNodes = 1; levelStart < nodes.size(); levelNodes *= KEYS + 1) {
+            levelStart += levelNodes;
+            depth++;
+        }
+        stale = false;
+    }
+
+    // How many of the node's keys are smaller than id. They're sorted, so that's also
+    // where id would go.
+    static int rank(const Node& node, int32_t id) {
+#if defined(HAVE_SSE2)
+        // a key that compares smaller gives an all-ones lane, i.e. -1, so adding them up counts them
+        __m128i target = _mm_set1_epi32(id);
+        const __m128i* keys = reinterpret_cast<const __m128i*>(node.keys);
+        __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_cmpgt_epi32(target, _mm_load_si128(keys)),
+                                                  _mm_cmpgt_epi32(target, _mm_load_si128(keys + 1))),
+                                    _mm_add_epi32(_mm_cmpgt_epi32(target, _mm_load_si128(keys + 2)),
+                                                  _mm_cmpgt_epi32(target, _mm_load_si128(keys + 3))));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));   // swap the halves and add
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));   // then neighbours
+        return -_mm_cvtsi128_si32(sum);
+#elif defined(HAVE_NEON)
+        int32x4_t target = vdupq_n_s32(id);
+        int32x4_t smaller = vdupq_n_s32(0);
+        for (int j = 0; j < KEYS; j += 4) {
+            smaller = vsubq_s32(smaller, vreinterpretq_s32_u32(vcltq_s32(vld1q_s32(&node.keys[j]), target)));
+        }
+        return vaddvq_s32(smaller);
+#else
+        int smaller = 0;
+        for (int i = 0; i < KEYS; i++) smaller += node.keys[i] < id;
+        return smaller;
+#endif
+    }
+
+    static void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    // found is the slot of the smallest key >= id seen on the way down
+    EventNode* resolve(size_t found, int id) const {
+        if (found == SIZE_MAX || nodes[found / KEYS].keys[found % KEYS] != id) return nullptr;
+        return events[found];
+    }
+
+public:
+    FrozenIdIndex() : depth(0), stale(true) {}
+
+    void markStale() { stale = true; }
+    bool isStale() const { return stale; }
+
+    EventNode* find(int id) {
+        if (stale) rebuild();
+        size_t found = SIZE_MAX;
+        for (size_t k = 0; k < nodes.size(); ) {
+            int i = rank(nodes[k], id);
+            found = i < KEYS ? k * KEYS + i : found;
+            k = child(k, i);
+        }
+        return resolve(found, id);
+    }
+
+    // found[i] = the event with ids[i], or null if there's none
+    void findMany(const int* ids, size_t count, EventNode** found) {
+        if (stale) rebuild();
+        size_t at[GROUP], slot[GROUP];
+        for (size_t start = 0; start < count; start += GROUP) {
+            size_t lanes = min(GROUP, count - start);
+            for (size_t j = 0; j < lanes; j++) {
+                at[j] = 0;
+                slot[j] = SIZE_MAX;
+            }
+            // every lane takes one step down before any takes the next, by then its node has arrived
+            for (int level = 0; level < depth; level++) {
+                for (size_t j = 0; j < lanes; j++) {
+                    if (at[j] >= nodes.size()) continue;   // the last level isn't always full
+                    int i = rank(nodes[at[j]], ids[start + j]);
+                    slot[j] = i < KEYS ? at[j] * KEYS + i : slot[j];
+                    at[j] = child(at[j], i);
+                    if (at[j] < nodes.size()) prefetch(&nodes[at[j]]);
+                }
+            }
+            for (size_t j = 0; j < lanes; j++) found[start + j] = resolve(slot[j], ids[start + j]);
+        }
+    }
+
+    void clear() {
+        nodes.clear();
+        events.clear();
+        depth = 0;
+        stale = true;
+    }
+
+    size_t bytes() const { return nodes.size() * sizeof(Node) + events.size() * sizeof(EventNode*); }
+};
+
+FrozenIdIndex frozenIdIndex;
+
+// Live schedule: one ID-ordered bucket per importance level (1-3). Creates,
+// removes and importance changes keep it current, so collecting the live schedule
+// is just reading the buckets back in order, no sorting. (Reports use their snapshot.)
+class ScheduleIndex {
+private:
+    map<int, EventNode*> buckets[3];
+
+    static int bucketFor(int importanceLevel) {
+        return min(max(importanceLevel, 1), 3) - 1;   // anything out of range gets filed at the nearest end
+    }
+
+public:
+    void insert(EventNode* event) { buckets[bucketFor(event->importanceLevel)][event->eventId] = event; }
+    void erase(EventNode* event) { buckets[bucketFor(event->importanceLevel)].erase(event->eventId); }
+
+    // Call after the event's importanceLevel was changed from oldLevel
+    void move(EventNode* event, int oldLevel) {
+        buckets[bucketFor(oldLevel)].erase(event->eventId);
+        insert(event);
+    }
+
+    // Events of one importance level (1-3), in ID order
+    const map<int, EventNode*>& level(int importanceLevel) const { return buckets[bucketFor(importanceLevel)]; }
+
+    bool empty() const { return buckets[0].empty() && buckets[1].empty() && buckets[2].empty(); }
+
+    void clear() {
+        for (auto& bucket : buckets) bucket.clear();
+    }
+};
+
+ScheduleIndex scheduleIndex;
+
+// Type-ahead search over event names. Each name is filed, lowercased, under every point where a
+// word starts ("summer jazz night", "jazz night", "night") in one sorted set, so a lookup is a
+// lower_bound plus a short walk and matches the start of the name or of any word in it.
+// Built on the first search so bulk loads don't pay for it, kept current on every change after.
+class NameIndex {
+private:
+    set<pair<string, EventNode*>> keys;
+    bool built;
+
+    static bool isWordChar(char c) { return isalnum((unsigned char)c) != 0; }
+
+    // Lowercased with runs of spaces squeezed to one, so queries don't have to match spacing
+    static string fold(string_view text) {
+        string folded;
+        folded.reserve(text.size());
+        for (char c : text) {
+            if (c == ' ' || c == '\t') {
+                if (!folded.empty() && folded.back() != ' ') folded.push_back(' ');
+            } else {
+                folded.push_back((char)tolower((unsigned char)c));
+            }
+        }
+        if (!folded.empty() && folded.back() == ' ') folded.pop_back();
+        return folded;
+    }
+
+    template <typename Visit>
+    static void forEachKey(const string& name, Visit visit) {
+        string folded = fold(name);
+        for (size_t i = 0; i < folded.size(); i++) {
+            if (isWordChar(folded[i]) && (i == 0 || !isWordChar(folded[i - 1]))) visit(folded.substr(i));
+        }
+    }
+
+public:
+    NameIndex() : built(false) {}
+
+    void insert(EventNode* event) {
+        if (!built) return;
+        forEachKey(event->name(), [&](string key) { keys.emplace(std::move(key), event); });
+    }
+
+    void erase(EventNode* event) {
+        if (!built) return;
+        forEachKey(event->name(), [&](string key) { keys.erase(make_pair(std::move(key), event)); });
+    }
+
+    // Forgets everything, the next search builds it again
+    void clear() {
+        keys.clear();
+        built = false;
+    }
+
+    // Up to limit events whose name, or a word in it, starts with the query, ignoring case.
+    // In alphabetical order of the matching text, each event once.
+    vector<EventNode*> search(string_view query, size_t limit) {
+        if (!built) {
+            // sorted first, so the set is filled in one linear pass
+            vector<pair<string, EventNode*>> all;
+            eventIndex.forEach([&all](EventNode* event) {
+                forEachKey(event->name(), [&](string key) { all.emplace_back(std::move(key), event); });
+            });
+            sort(all.begin(), all.end());
+            keys = set<pair<string, EventNode*>>(make_move_iterator(all.begin()), make_move_iterator(all.end()));
+            built = true;
+        }
+
+        vector<EventNode*> found;
+        string prefix = fold(query);
+        if (prefix.empty()) return found;
+        for (auto it = keys.lower_bound(make_pair(prefix, (EventNode*)nullptr));
+             it != keys.end() && found.size() < limit && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (find(found.begin(), found.end(), it->second) == found.end()) found.push_back(it->second);
+        }
+        return found;
+    }
+
+    bool isBuilt() const { return built; }
+    size_t keyCount() const { return keys.size(); }
+};
+
+NameIndex nameIndex;
+
+// Which events someone is registered for, across all four trees: normalized phone number ->
+// events, and normalized name -> events. Each entry counts how many times the person is on that
+// event's list, so undoing one of two identical registrations keeps the event filed.
+// Same deal as the name index: built on the first lookup, kept current on every change after.
+class AttendeeIndex {
+private:
+    struct Registration {
+        int eventId;
+        int count;
+    };
+    typedef unordered_map<string, vector<Registration>> Postings;
+
+    Postings byPhone;
+    Postings byName;
+    bool built;
+
+    static void add(Postings& postings, string key, int eventId) {
+        if (key.empty()) return;
+        vector<Registration>& events = postings[std::move(key)];
+        for (Registration& registration : events) {
+            if (registration.eventId == eventId) {
+                registration.count++;
+                return;
+            }
+        }
+        events.push_back(Registration{eventId, 1});
+    }
+
+    static void drop(Postings& postings, const string& key, int eventId) {
+        auto entry = postings.find(key);
+        if (entry == postings.end()) return;
+        vector<Registration>& events = entry->second;
+        for (size_t i = 0; i < events.size(); i++) {
+            if (events[i].eventId != eventId) continue;
+            if (--events[i].count == 0) {
+                events[i] = events.back();
+                events.pop_back();
+            }
+            break;
+        }
+        if (events.empty()) postings.erase(entry);
+    }
+
+    void file(int eventId, const Attendee& attendee) {
+        add(byPhone, normalizePhone(attendee.phoneNumber), eventId);
+        add(byName, normalizeName(attendee.fullName), eventId);
+    }
+
+    void build() {
+        eventIndex.forEach([this](EventNode* event) {
+            for (const Attendee& attendee : event->attendees) file(event->eventId, attendee);
+        });
+        built = true;
+    }
+
+    // Resolved through the event index, in ID order
+    static vector<EventNode*> eventsIn(const Postings& postings, const string& key) {
+        vector<EventNode*> found;
+        auto entry = postings.find(key);
+        if (entry == postings.end()) return found;
+        for (const Registration& registration : entry->second) {
+            if (EventNode* event = eventIndex.find(registration.eventId)) found.push_back(event);
+        }
+        sort(found.begin(), found.end(), [](EventNode* a, EventNode* b) { return a->eventId < b->eventId; });
+        return found;
+    }
+
+public:
+    AttendeeIndex() : built(false) {}
+
+    // Only the digits count, so "0801 234 5678" and "08012345678" are the same person
+    static string normalizePhone(string_view phone) {
+        string digits;
+        for (char c : phone) {
+            if (isdigit((unsigned char)c)) digits.push_back(c);
+        }
+        return digits;
+    }
+
+    void insert(const EventNode* event, const Attendee& attendee) {
+        if (built) file(event->eventId, attendee);
+    }
+
+    void erase(const EventNode* event, const Attendee& attendee) {
+        if (!built) return;
+        drop(byPhone, normalizePhone(attendee.phoneNumber), event->eventId);
+        drop(byName, normalizeName(attendee.fullName), event->eventId);
+    }
+
+    // For an event that's going away, every one of its registrations at once
+    void eraseEvent(const EventNode* event) {
+        for (const Attendee& attendee : event->attendees) erase(event, attendee);
+    }
+
+    // Forgets everything, the next lookup builds it again. Loaders call this first so their
+    // threads can fill attendee lists without touching the index.
+    void clear() {
+        byPhone.clear();
+        byName.clear();
+        built = false;
+    }
+
+    vector<EventNode*> eventsForPhone(string_view phone) {
+        if (!built) build();
+        return eventsIn(byPhone, normalizePhone(phone));
+    }
+
+    vector<EventNode*> eventsForName(string_view name) {
+        if (!built) build();
+        return eventsIn(byName, normalizeName(name));
+    }
+
+    bool isBuilt() const { return built; }
+    size_t phoneCount() const { return byPhone.size(); }
+};
+
+AttendeeIndex attendeeIndex;
+
+// ===== Report snapshots =====
+// Reports used to walk the live trees, which registrations and updates change in place, so a long
+// report had to hold the state lock from start to finish. Once the first report asks for it, a
+// second read-only copy of the catalog is kept alongside, built from immutable nodes. A change
+// copies only the path from a root down to the changed event (O(log n) new nodes) and publishes
+// the new roots, everything else is shared with the older versions. A reader grabs the current
+// version in O(1) and walks it with no lock while writers carry on. Versions are reference
+// counted, so an old one is freed as soon as the last report holding it is done.
+
+// An event's attendees as a shared list, newest first: registering puts one link in front,
+// undoing it drops that link again, and the older links are shared by every version
+struct AttendeeLink {
+    Attendee attendee;
+    shared_ptr<const AttendeeLink> previous;   // whoever registered before, null for the first
+
+    AttendeeLink(const Attendee& person, shared_ptr<const AttendeeLink> before)
+        : attendee(person), previous(std::move(before)) {}
+
+    // Letting a long list go recursively could run out of stack. Links freed while another one
+    // is being freed only queue their tail here, and the outermost one lets go of them in a loop.
+    ~AttendeeLink() {
+        static thread_local vector<shared_ptr<const AttendeeLink>> tails;
+        static thread_local bool draining = false;
+        if (!previous) return;
+        tails.push_back(std::move(previous));
+        if (draining) return;
+        draining = true;
+        while (!tails.empty()) {
+            shared_ptr<const AttendeeLink> tail = std::move(tails.back());
+            tails.pop_back();
+        }
+        draining = false;
+    }
+};
+
+// One event as a report sees it, never changed once published. Keeps its own copy of the name
+// so it outlives the live node.
+struct EventVersion {
+    int eventId;
+    int importanceLevel;
+    EventCategory category;
+    string eventName;
+    shared_ptr<const AttendeeLink> lastAttendee;
+    size_t attendeeCount;
+
+    const string& name() const { return eventName; }
+    const char* type() const { return categoryNames[category]; }
+
+    // In registration order
+    vector<reference_wrapper<const Attendee>> attendees() const {
+        vector<reference_wrapper<const Attendee>> inOrder;
+        inOrder.reserve(attendeeCount);
+        for (const AttendeeLink* link = lastAttendee.get(); link; link = link->previous.get()) {
+            inOrder.push_back(cref(link->attendee));
+        }
+        reverse(inOrder.begin(), inOrder.end());
+        return inOrder;
+    }
+};
+
+// Persistent AVL node, keyed by event ID like the live trees
+struct VersionNode {
+    shared_ptr<const EventVersion> event;
+    shared_ptr<const VersionNode> left, right;
+    int height;
+
+    VersionNode(shared_ptr<const EventVersion> version, shared_ptr<const VersionNode> leftTree,
+                shared_ptr<const VersionNode> rightTree)
+        : event(std::move(version)), left(std::move(leftTree)), right(std::move(rightTree)),
+          height(1 + max(left ? left->height : 0, right ? right->height : 0)) {}
+};
+
+typedef shared_ptr<const VersionNode> VersionTree;
+
+// The whole catalog at one point in time, in the same four trees as the live one
+struct CatalogVersion {
+    VersionTree trees[CATEGORY_COUNT];
+    size_t eventCounts[CATEGORY_COUNT];
+    size_t attendeeCounts[CATEGORY_COUNT];
+};
+
+typedef shared_ptr<const CatalogVersion> CatalogSnapshot;
+
+// In-order walk over one tree of a snapshot. Only valid while the snapshot is held.
+class VersionIterator {
+private:
+    vector<const VersionNode*> path;
+
+    void pushLeft(const VersionNode* node) {
+        for (; node; node = node->left.get()) path.push_back(node);
+    }
+
+public:
+    explicit VersionIterator(const VersionTree& root) {
+        path.reserve(root ? root->height + 1 : 1);
+        pushLeft(root.get());
+    }
+
+    bool done() const { return path.empty(); }
+    const EventVersion& current() const { return *path.back()->event; }
+
+    void next() {
+        const VersionNode* node = path.back();
+        path.pop_back();
+        pushLeft(node->right.get());
+    }
+};
+
+class EventVersions {
+private:
+    CatalogSnapshot head;        // the latest version, only the thread making changes touches it
+    CatalogSnapshot published;   // what readers pick up, only ever swapped atomically
+
+    static int heightOf(const VersionTree& tree) { return tree ? tree->height : 0; }
+
+    static VersionTree join(shared_ptr<const EventVersion> event, VersionTree left, VersionTree right) {
+        return make_shared<const VersionNode>(std::move(event), std::move(left), std::move(right));
+    }
+
+    // Like the AVL rebalance on the live tree, except the rotations build new nodes instead of relinking
+    static VersionTree balance(shared_ptr<const EventVersion> event, VersionTree left, VersionTree right) {
+        if (heightOf(left) > heightOf(right) + 1) {
+            if (heightOf(left->left) >= heightOf(left->right)) {
+                return join(left->event, left->left, join(std::move(event), left->right, std::move(right)));
+            }
+            const VersionTree& middle = left->right;
+            return join(middle->event, join(left->event, left->left, middle->left),
+                        join(std::move(event), middle->right, std::move(right)));
+        }
+        if (heightOf(right) > heightOf(left) + 1) {
+            if (heightOf(right->right) >= heightOf(right->left)) {
+                return join(right->event, join(std::move(event), std::move(left), right->left), right->right);
+            }
+            const VersionTree& middle = right->left;
+            return join(middle->event, join(std::move(event), std::move(left), middle->left),
+                        join(right->event, middle->right, right->right));
+        }
+        return join(std::move(event), std::move(left), std::move(right));
+    }
+
+    // Adds the event, or replaces the version with the same ID
+    static VersionTree put(const VersionTree& tree, const shared_ptr<const EventVersion>& event) {
+        if (!tree) return join(event, nullptr, nullptr);
+        if (event->eventId < tree->event->eventId) return balance(tree->event, put(tree->left, event), tree->right);
+        if (event->eventId > tree->event->eventId) return balance(tree->event, tree->left, put(tree->right, event));
+        return join(event, tree->left, tree->right);
+    }
+
+    static VersionTree withoutMin(const VersionTree& tree, shared_ptr<const EventVersion>& minEvent) {
+        if (!tree->left) {
+            minEvent = tree->event;
+            return tree->right;
+        }
+        return balance(tree->event, withoutMin(tree->left, minEvent), tree->right);
+    }
+
+    static VersionTree without(const VersionTree& tree, int eventId) {
+        if (!tree) return tree;
+        if (eventId < tree->event->eventId) return balance(tree->event, without(tree->left, eventId), tree->right);
+        if (eventId > tree->event->eventId) return balance(tree->event, tree->left, without(tree->right, eventId));
+        if (!tree->left) return tree->right;
+        if (!tree->right) return tree->left;
+        shared_ptr<const EventVersion> successor;
+        VersionTree right = withoutMin(tree->right, successor);
+        return balance(std::move(successor), tree->left, std::move(right));
+    }
+
+    static const EventVersion* lookup(const VersionTree& tree, int eventId) {
+        for (const VersionNode* node = tree.get(); node; ) {
+            if (eventId == node->event->eventId) return node->event.get();
+            node = eventId < node->event->eventId ? node->left.get() : node->right.get();
+        }
+        return nullptr;
+    }
+
+    static VersionTree buildBalanced(const vector<shared_ptr<const EventVersion>>& sorted, int low, int high) {
+        if (low > high) return nullptr;
+        int middle = low + (high - low) / 2;
+        return join(sorted[middle], buildBalanced(sorted, low, middle - 1), buildBalanced(sorted, middle + 1, high));
+    }
+
+    // The event's fields as they are now, keeping the attendee list it already has
+    static shared_ptr<EventVersion> fieldsOf(const EventNode* event, const EventVersion* old) {
+        auto version = make_shared<EventVersion>();
+        version->eventId = event->eventId;
+        version->importanceLevel = event->importanceLevel;
+        version->category = event->category;
+        version->eventName = event->name();
+        if (old) {
+            version->lastAttendee = old->lastAttendee;
+            version->attendeeCount = old->attendeeCount;
+        } else {
+            version->attendeeCount = 0;
+            for (const Attendee& attendee : event->attendees) {
+                version->lastAttendee = make_shared<const AttendeeLink>(attendee, std::move(version->lastAttendee));
+                version->attendeeCount++;
+            }
+        }
+        return version;
+    }
+
+    // Which tree holds the ID, CATEGORY_COUNT if none. An update can change an event's type
+    // without moving it, so this looks instead of trusting the type.
+    int treeHolding(int eventId, const EventVersion*& found) const {
+        for (int c = 0; c < CATEGORY_COUNT; c++) {
+            found = lookup(head->trees[c], eventId);
+            if (found) return c;
+        }
+        return CATEGORY_COUNT;
+    }
+
+    void publish(shared_ptr<CatalogVersion> next) {
+        head = std::move(next);
+        atomic_store(&published, head);
+    }
+
+    // Swaps one event's version in a tree, adjusting that tree's attendee total
+    void replace(int tree, shared_ptr<const EventVersion> version, size_t attendeesBefore) {
+        auto next = make_shared<CatalogVersion>(*head);
+        next->attendeeCounts[tree] += version->attendeeCount;
+        next->attendeeCounts[tree] -= attendeesBefore;
+        next->trees[tree] = put(next->trees[tree], version);
+        publish(std::move(next));
+    }
+
+public:
+    // Nothing is kept until the first snapshot, so loads and benchmarks don't pay for it
+    bool isBuilt() const { return head != nullptr; }
+
+    // Copies the live trees. Must run where they can be read safely, like any other read of them.
+    void build(EventNode* const roots[CATEGORY_COUNT]) {
+        auto catalog = make_shared<CatalogVersion>();
+        vector<shared_ptr<const EventVersion>> sorted;
+        vector<EventNode*> path;
+        for (int c = 0; c < CATEGORY_COUNT; c++) {
+            sorted.clear();
+            catalog->attendeeCounts[c] = 0;
+            for (EventNode* node = roots[c]; node || !path.empty(); node = node->rightChild) {
+                for (; node; node = node->leftChild) path.push_back(node);
+                node = path.back();
+                path.pop_back();
+                sorted.push_back(fieldsOf(node, nullptr));
+                catalog->attendeeCounts[c] += node->attendees.size();
+            }
+            catalog->eventCounts[c] = sorted.size();
+            catalog->trees[c] = buildBalanced(sorted, 0, (int)sorted.size() - 1);
+        }
+        publish(std::move(catalog));
+    }
+
+    // The latest version, O(1) and safe from any thread. Null until build() has run.
+    CatalogSnapshot current() const { return atomic_load(&published); }
+
+    // The writer hooks. New events go in their own category's tree, like insertEvent().
+    void insert(const EventNode* event) {
+        if (!isBuilt()) return;
+        auto version = fieldsOf(event, nullptr);
+        auto next = make_shared<CatalogVersion>(*head);
+        next->trees[event->category] = put(next->trees[event->category], version);
+        next->eventCounts[event->category]++;
+        next->attendeeCounts[event->category] += version->attendeeCount;
+        publish(std::move(next));
+    }
+
+    void erase(int eventId) {
+        if (!isBuilt()) return;
+        const EventVersion* old;
+        int tree = treeHolding(eventId, old);
+        if (tree == CATEGORY_COUNT) return;
+        auto next = make_shared<CatalogVersion>(*head);
+        next->trees[tree] = without(next->trees[tree], eventId);
+        next->eventCounts[tree]--;
+        next->attendeeCounts[tree] -= old->attendeeCount;
+        publish(std::move(next));
+    }
+
+    // After the event's name, type or importance changed
+    void refresh(const EventNode* event) {
+        if (!isBuilt()) return;
+        const EventVersion* old;
+        int tree = treeHolding(event->eventId, old);
+        if (tree == CATEGORY_COUNT) return;
+        replace(tree, fieldsOf(event, old), old->attendeeCount);
+    }
+
+    void pushAttendee(const EventNode* event, const Attendee& attendee) {
+        if (!isBuilt()) return;
+        const EventVersion* old;
+        int tree = treeHolding(event->eventId, old);
+        if (tree == CATEGORY_COUNT) return;
+        auto version = make_shared<EventVersion>(*old);
+        version->lastAttendee = make_shared<const AttendeeLink>(attendee, old->lastAttendee);
+        version->attendeeCount++;
+        replace(tree, std::move(version), old->attendeeCount);
+    }
+
+    // Drops one attendee. The ones registered after it (newerCount, usually none) get new
+    // links, everything older stays shared.
+    void removeAttendee(const EventNode* event, size_t newerCount) {
+        if (!isBuilt()) return;
+        const EventVersion* old;
+        int tree = treeHolding(event->eventId, old);
+        if (tree == CATEGORY_COUNT) return;
+        vector<const Attendee*> newer;
+        const AttendeeLink* link = old->lastAttendee.get();
+        for (; link && newer.size() < newerCount; link = link->previous.get()) newer.push_back(&link->attendee);
+        if (!link) return;
+        auto version = make_shared<EventVersion>(*old);
+        version->lastAttendee = link->previous;
+        for (size_t i = newer.size(); i-- > 0; ) {
+            version->lastAttendee = make_shared<const AttendeeLink>(*newer[i], std::move(version->lastAttendee));
+        }
+        version->attendeeCount--;
+        replace(tree, std::move(version), old->attendeeCount);
+    }
+
+    // Stops keeping versions. Reports still holding one keep it until they let go.
+    void clear() {
+        head.reset();
+        atomic_store(&published, CatalogSnapshot());
+    }
+};
+
+EventVersions eventVersions;
+
+// The catalog as of now for a report to walk at its own pace. The first call copies the live
+// trees, so make that one where they can be read (the menu thread or under the state lock).
+CatalogSnapshot takeSnapshot(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    if (!eventVersions.isBuilt()) {
+        EventNode* roots[] = {seminars, sports, competitions, others};
+        eventVersions.build(roots);
+    }
+    return eventVersions.current();
+}
+
+// The indexes below, the event pool and the undo history are shared by all four categories.
+// The menu has them to itself, EventStore calls take this while they touch them.
+mutex indexLock;
+
+// Every place that adds or drops an event from a tree goes through these so the indexes never drift
+void indexEvent(EventNode* event) {
+    eventIndex.insert(event);
+    frozenIdIndex.markStale();
+    scheduleIndex.insert(event);
+    nameIndex.insert(event);
+    eventVersions.insert(event);
+}
+
+void unindexEvent(EventNode* event) {
+    eventIndex.erase(event->eventId);
+    frozenIdIndex.markStale();
+    scheduleIndex.erase(event);
+    nameIndex.erase(event);
+    attendeeIndex.eraseEvent(event);
+    eventVersions.erase(event->eventId);
+}
+
+// Registrations don't touch anything shared unless one of these indexes was asked for, so
+// front-desk clients registering for different events only take indexLock when they must.
+// (Both only get built or dropped with the state lock held exclusively.)
+void indexAttendee(const EventNode* event, const Attendee& attendee) {
+    if (!attendeeIndex.isBuilt() && !eventVersions.isBuilt()) return;
+    lock_guard<mutex> guard(indexLock);
+    attendeeIndex.insert(event, attendee);
+    eventVersions.pushAttendee(event, attendee);
+}
+
+void unindexAttendee(const EventNode* event, const Attendee& attendee, size_t newerCount) {
+    if (!attendeeIndex.isBuilt() && !eventVersions.isBuilt()) return;
+    lock_guard<mutex> guard(indexLock);
+    attendeeIndex.erase(event, attendee);
+    eventVersions.removeAttendee(event, newerCount);
+}
+
+void publishEvent(EventNode* event) {
+    eventVersions.refresh(event);
+}
+
+void renameEvent(EventNode* event, string_view name) {
+    nameIndex.erase(event);
+    event->rename(name);
+    nameIndex.insert(event);
+}
+
+void setImportance(EventNode* event, int level) {
+    int oldLevel = event->importanceLevel;
+    event->importanceLevel = level;
+    scheduleIndex.move(event, oldLevel);
+}
+
+// Bounded multi-producer/multi-consumer ring (Dmitry Vyukov's design). Every cell
+// carries a sequence number that says whose turn it is, so door kiosks pushing and
+// staff stations popping only ever race on one compare-and-swap, never a lock.
+template <typename T>
+class CheckInRing {
+private:
+    struct Cell {
+        atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos;   // own cache lines so producers and consumers don't fight over one
+    alignas(64) atomic<size_t> dequeuePos;
+
+    static T* valueIn(Cell& cell) { return reinterpret_cast<T*>(cell.storage); }
+
+public:
+    explicit CheckInRing(size_t capacity) : enqueuePos(0), dequeuePos(0) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++) cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    ~CheckInRing() {
+        T dropped;
+        while (tryPop(dropped)) {}
+    }
+
+    CheckInRing(const CheckInRing&) = delete;
+    CheckInRing& operator=(const CheckInRing&) = delete;
+
+    // False when the ring is full
+    bool tryPush(T value) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+            if (difference == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    new (cell.storage) T(std::move(value));
+                    cell.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // False when the ring is empty
+    bool tryPop(T& out) {
+        return popBatch(&out, 1) == 1;
+    }
+
+    // Claims up to maxCount ready entries with a single compare-and-swap and moves them into out.
+    // Returns how many it took.
+    size_t popBatch(T* out, size_t maxCount) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for (;;) {
+            // count how many cells in a row starting at pos are already filled
+            size_t ready = 0;
+            while (ready < maxCount) {
+                size_t sequence = cells[(pos + ready) & mask].sequence.load(memory_order_acquire);
+                if ((intptr_t)sequence - (intptr_t)(pos + ready + 1) != 0) break;
+                ready++;
+            }
+            if (ready == 0) {
+                size_t sequence = cells[pos & mask].sequence.load(memory_order_acquire);
+                if ((intptr_t)sequence - (intptr_t)(pos + 1) < 0) return 0;   // empty
+                pos = dequeuePos.load(memory_order_relaxed);                     // someone else took it
+                continue;
+            }
+            if (dequeuePos.compare_exchange_weak(pos, pos + ready, memory_order_relaxed)) {
+                for (size_t i = 0; i < ready; i++) {
+                    Cell& cell = cells[(pos + i) & mask];
+                    T* value = valueIn(cell);
+                    out[i] = std::move(*value);
+                    value->~T();
+                    cell.sequence.store(pos + i + mask + 1, memory_order_release);
+                }
+                return ready;
+            }
+        }
+    }
+
+    // Copies the front entry without removing it. Only meaningful when no other
+    // thread is popping at the same time, which is how the menu uses it.
+    bool peek(T& out) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        if (cell.sequence.load(memory_order_acquire) != pos + 1) return false;
+        out = *valueIn(cell);
+        return true;
+    }
+
+    // Exact when nothing is running concurrently, a close estimate otherwise
+    size_t size() const {
+        size_t tail = enqueuePos.load(memory_order_relaxed);
+        size_t head = dequeuePos.load(memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask + 1; }
+};
+
+CheckInRing<CheckIn> checkInQueue(4096);
+
+// The tree's allocator policy: events come out of eventPool's slabs, and going back takes them
+// out of the indexes first (destroy is defined with the rest of the BST code)
+struct EventPoolAllocator {
+    template <typename... Args>
+    static EventNode* create(Args&&... args) { return eventPool.create(std::forward<Args>(args)...); }
+    static void destroy(EventNode* event);
+};
+
+// Each category is an AVL tree linked through the nodes themselves, keyed on eventId. The tree
+// code is the shared one in intrusive_tree.h, we only keep the four roots.
+typedef intrusive::TreeAlgorithms<EventNode, intrusive::MemberKey<EventNode, int, &EventNode::eventId>,
+                                  intrusive::ChildLinks<EventNode, &EventNode::leftChild, &EventNode::rightChild>,
+                                  intrusive::AvlBalancing<EventNode, &EventNode::height>,
+                                  EventPoolAllocator> EventTree;
+
+// The tree functions live further down with the rest of the BST code
+EventNode* findEvent(EventNode* root, int targetId);
+EventNode* insertEvent(EventNode*& root, int id, string_view name, EventCategory category, int importance);
+void releaseAllEvents(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others);
+
+// ===== Tree traversal =====
+
+// In-order walk over one category tree with its own stack instead of recursion, so a deep
+// tree can't blow the call stack and the caller can stop at any point. Given an ID range it
+// only goes into subtrees that can hold IDs in it, and stops after the last one.
+typedef EventTree::Iterator EventTreeIterator;
+
+// Every event of one tree with lowId <= ID <= highId, in ID order. Costs O(log n + matches).
+vector<EventNode*> rangeQuery(EventNode* root, int lowId, int highId) {
+    vector<EventNode*> found;
+    for (EventTreeIterator it(root, lowId, highId); !it.done(); it.next()) found.push_back(it.current());
+    return found;
+}
+
+// The same across all four categories, merged back into ID order
+vector<EventNode*> rangeQuery(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                              int lowId, int highId) {
+    vector<EventNode*> found;
+    for (EventNode* root : {seminars, sports, competitions, others}) {
+        size_t middle = found.size();
+        for (EventTreeIterator it(root, lowId, highId); !it.done(); it.next()) found.push_back(it.current());
+        inplace_merge(found.begin(), found.begin() + middle, found.end(),
+                      [](EventNode* a, EventNode* b) { return a->eventId < b->eventId; });
+    }
+    return found;
+}
+
+// In ID order, so loading never has to sort
+void saveEventToFile(ostream &outFile, EventNode* root) {
+    for (EventTreeIterator it(root); !it.done(); it.next()) {
+        EventNode* event = it.current();
+        outFile << event->eventId << ", " << event->name() << ", " 
+                << event->type() << ", " << event->importanceLevel << "\n";
+    }
+}
+
+// Both data files are split into one segment per category (seminars, sports, competitions, others)
+// behind a header line with the byte length of each, "#categories 120 3400 0 57", so the loader can
+// hand every segment to its own thread. Files without the header are read the old way.
+// A snapshot written alongside the journal adds the last journal record it holds, "... 57 journal 812".
+const char* const CATEGORY_HEADER = "#categories";
+
+// The journal sequence number each data file says it already holds, filled in by the loaders.
+// Replay skips records at or below it.
+struct JournalCoverage {
+    uint64_t events = 0;
+    uint64_t attendees = 0;
+};
+JournalCoverage snapshotCoverage;
+
+string joinCategorySegments(const string segments[4], uint64_t journalSequence = 0) {
+    string joined = CATEGORY_HEADER;
+    for (int i = 0; i < 4; i++) joined += " " + to_string(segments[i].size());
+    if (journalSequence > 0) joined += " journal " + to_string(journalSequence);
+    joined += "\n";
+    for (int i = 0; i < 4; i++) joined += segments[i];
+    return joined;
+}
+
+// Writes path.tmp and renames it over path, so a crash mid-write never leaves a half-written file
+bool writeFileAtomically(const string& path, const string& contents) {
+    string tempPath = path + ".tmp";
+    {
+        ofstream outFile(tempPath, ios::binary | ios::trunc);
+        if (!outFile.is_open()) return false;
+        outFile.write(contents.data(), (streamsize)contents.size());
+        outFile.flush();
+        if (!outFile) return false;
+    }
+    // the data has to be on disk before the rename makes it the real file, and the rename
+    // itself only sticks once the directory is synced
+    if (!syncPath(tempPath)) return false;
+    instrumentation.add(instrumentation.bytesWritten, contents.size());
+    if (rename(tempPath.c_str(), path.c_str()) != 0) return false;
+    syncParentDirectory(path);
+    return true;
+}
+
+string serializeEvents(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                       uint64_t journalSequence = 0) {
+    EventNode* roots[] = {seminars, sports, competitions, others};
+    string segments[4];
+    for (int i = 0; i < 4; i++) {
+        ostringstream outFile;
+        saveEventToFile(outFile, roots[i]);
+        segments[i] = outFile.str();
+    }
+    return joinCategorySegments(segments, journalSequence);
+}
+
+// Saves all our events to disk for data persisitence
+void saveAllEvents(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    if (!writeFileAtomically("events.txt", serializeEvents(seminars, sports, competitions, others))) {
+        cout << "Oops! Couldn't open the events file for saving. Check permissions." << endl;
+    }
+}
+
+
+string trimSpaces(const string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == string::npos) return "";
+    return text.substr(first, text.find_last_not_of(" \t\r") + 1 - first);
+}
+
+EventNode** categoryTree(EventCategory category, EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    EventNode** trees[CATEGORY_COUNT] = {&seminars, &sports, &competitions, &others};
+    return trees[category];
+}
+
+// Which of the four trees an event type belongs to, nullptr if it isn't one of ours
+EventNode** categoryTree(const string& type, EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    EventCategory category;
+    if (!parseCategory(type, category)) return nullptr;
+    return categoryTree(category, seminars, sports, competitions, others);
+}
+
+// ===== Zero-copy file parsing =====
+// The whole file is mapped (or read in one go) and the parser hands out string_views
+// into that buffer. Nothing is copied until a field ends up in an EventNode.
+
+class MappedFile {
+private:
+    const char* data;
+    size_t length;
+    bool mapped;
+    string fallback;   // used when mmap isn't available or fails
+
+public:
+    explicit MappedFile(const string& path) : data(nullptr), length(0), mapped(false) {
+#ifdef HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0) {
+                void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    data = static_cast<const char*>(mapping);
+                    length = (size_t)info.st_size;
+                    mapped = true;
+                }
+            } else if (fstat(fd, &info) == 0) {
+                data = "";   // empty file, still counts as opened
+            }
+            ::close(fd);
+            if (data) return;
+        }
+#endif
+        ifstream inFile(path, ios::binary);
+        if (!inFile.is_open()) return;
+        inFile.seekg(0, ios::end);
+        fallback.resize((size_t)inFile.tellg());
+        inFile.seekg(0, ios::beg);
+        inFile.read(&fallback[0], (streamsize)fallback.size());
+        data = fallback.data();
+        length = fallback.size();
+    }
+
+    ~MappedFile() {
+#ifdef HAVE_MMAP
+        if (mapped) munmap(const_cast<char*>(data), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return data != nullptr; }
+    string_view contents() const { return string_view(data, length); }
+};
+
+// Hands out one line at a time (without the newline) from a buffer
+bool nextLine(string_view& rest, string_view& line) {
+    if (rest.empty()) return false;
+    size_t end = rest.find('\n');
+    if (end == string_view::npos) {
+        line = rest;
+        rest = string_view();
+    } else {
+        line = rest.substr(0, end);
+        rest.remove_prefix(end + 1);
+    }
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return true;
+}
+
+string_view trimView(string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+bool parseNumber(string_view text, int& value) {
+    text = trimView(text);
+    auto result = from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == errc() && result.ptr != text.data();
+}
+
+bool sameIgnoringCase(string_view text, string_view lowerWord) {
+    if (text.size() != lowerWord.size()) return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (tolower((unsigned char)text[i]) != lowerWord[i]) return false;
+    }
+    return true;
+}
+
+// Splits one CSV row into its fields. A field in double quotes can hold commas, and "" inside
+// it is a literal quote. False if a quote is left open.
+bool splitCsvRow(string_view line, vector<string>& fields) {
+    fields.clear();
+    size_t pos = 0;
+    for (;;) {
+        string field;
+        if (pos < line.size() && line[pos] == '"') {
+            pos++;
+            for (;;) {
+                if (pos >= line.size()) return false;
+                if (line[pos] == '"') {
+                    if (pos + 1 < line.size() && line[pos + 1] == '"') {
+                        field.push_back('"');
+                        pos += 2;
+                        continue;
+                    }
+                    pos++;
+                    break;
+                }
+                field.push_back(line[pos++]);
+            }
+            size_t comma = line.find(',', pos);
+            pos = comma == string_view::npos ? line.size() : comma;   // anything after the closing quote is dropped
+        } else {
+            size_t comma = line.find(',', pos);
+            size_t end = comma == string_view::npos ? line.size() : comma;
+            field.assign(line.substr(pos, end - pos));
+            pos = end;
+        }
+        fields.push_back(string(trimView(field)));
+        if (pos >= line.size()) return true;
+        pos++;   // past the comma
+    }
+}
+
+// Cuts a file written by joinCategorySegments back into its four segments.
+// False if it doesn't start with the header or the lengths don't add up (an old-style file).
+// journalSequence gets the header's journal number, 0 if it has none.
+bool splitCategorySegments(string_view contents, string_view segments[4], uint64_t* journalSequence = nullptr) {
+    if (journalSequence) *journalSequence = 0;
+    string_view header;
+    if (!nextLine(contents, header)) return false;
+    string_view word = header.substr(0, header.find(' '));
+    if (word != CATEGORY_HEADER) return false;
+    header.remove_prefix(word.size());
+
+    for (int i = 0; i < 4; i++) {
+        header = trimView(header);
+        size_t length;
+        auto result = from_chars(header.data(), header.data() + header.size(), length);
+        if (result.ec != errc() || length > contents.size()) return false;
+        header.remove_prefix(result.ptr - header.data());
+        segments[i] = contents.substr(0, length);
+        contents.remove_prefix(length);
+    }
+
+    header = trimView(header);
+    if (journalSequence && header.substr(0, 8) == "journal ") {
+        header = trimView(header.substr(8));
+        uint64_t sequence;
+        auto result = from_chars(header.data(), header.data() + header.size(), sequence);
+        if (result.ec == errc()) *journalSequence = sequence;
+    }
+    return true;
+}
+
+// Runs work(0..3), one category each, on separate threads when there's more than one core
+void runPerCategory(const function<void(int)>& work) {
+    if (thread::hardware_concurrency() <= 1) {
+        for (int i = 0; i < 4; i++) work(i);
+        return;
+    }
+    vector<thread> workers;
+    for (int i = 1; i < 4; i++) workers.emplace_back(work, i);
+    work(0);
+    for (thread& worker : workers) worker.join();
+}
+
+// Turns one category's loaded events into a balanced tree
+EventNode* buildCategoryTree(vector<EventNode*>& loadedEvents) {
+    // The booking system hands out increasing IDs so the file is normally already sorted,
+    // only sort when it isn't, then build the tree bottom-up in one O(n) pass
+    auto byId = [](EventNode* a, EventNode* b) { return a->eventId < b->eventId; };
+    if (!is_sorted(loadedEvents.begin(), loadedEvents.end(), byId)) {
+        stable_sort(loadedEvents.begin(), loadedEvents.end(), byId);
+    }
+    return EventTree::build(loadedEvents.data(), loadedEvents.size());
+}
+
+struct EventLine {
+    int eventId;
+    string_view name;
+    EventCategory category;
+    int importanceLevel;
+};
+
+// One "id, name, type, importance" line as saveEventToFile writes it, the name may itself contain
+// commas. A type that isn't one of ours gets unknownType. False if the line doesn't parse.
+bool parseEventLine(string_view line, EventCategory unknownType, EventLine& event) {
+    size_t firstComma = line.find(',');
+    size_t lastComma = line.rfind(',');
+    if (firstComma == string_view::npos || lastComma == firstComma) return false;
+    size_t typeComma = line.rfind(',', lastComma - 1);
+    if (typeComma == string_view::npos || typeComma < firstComma) return false;
+
+    if (!parseNumber(line.substr(0, firstComma), event.eventId)) return false;
+    if (!parseNumber(line.substr(lastComma + 1), event.importanceLevel)) return false;
+    event.name = trimView(line.substr(firstComma + 1, typeComma - firstComma - 1));
+    string_view eventType = trimView(line.substr(typeComma + 1, lastComma - typeComma - 1));
+    if (!parseCategory(eventType, event.category)) event.category = unknownType;
+    return true;
+}
+
+//loads all prewritten data when the code is actually running, one event per line
+void loadEventFromFile(string_view contents, vector<EventNode*>& seminars, vector<EventNode*>& sports,
+                       vector<EventNode*>& competitions, vector<EventNode*>& others) {
+    string_view line;
+
+    while (nextLine(contents, line)) {
+        // anything that isn't one of the other three has always ended up under others
+        EventLine parsed;
+        if (!parseEventLine(line, OTHERS, parsed)) continue;
+        EventCategory category = parsed.category;
+
+        // the name is interned, so repeated names cost nothing extra
+        EventNode* newEvent = eventPool.create(parsed.eventId, parsed.name, category, parsed.importanceLevel);
+        if (category == SEMINAR) seminars.push_back(newEvent);
+        else if (category == SPORTS) sports.push_back(newEvent);
+        else if (category == COMPETITION) competitions.push_back(newEvent);
+        else others.push_back(newEvent);
+        indexEvent(newEvent);
+    }
+}
+
+// Parses one category's segment of a sharded events file. Runs on a loader thread, so it only
+// touches its own vector and the pool's thread-safe create; indexing happens after the join.
+// The segment is the event's home tree (see homeTree) and the type column its type, the two
+// differ once an update has changed the type.
+void loadEventSegment(string_view contents, EventCategory segmentCategory, vector<EventNode*>& loaded) {
+    string_view line;
+
+    while (nextLine(contents, line)) {
+        EventLine parsed;
+        if (!parseEventLine(line, segmentCategory, parsed)) continue;
+        loaded.push_back(eventPool.createConcurrent(parsed.eventId, parsed.name, parsed.category,
+                                                    parsed.importanceLevel));
+    }
+}
+
+//this then builds the 4 individual BSTs for each event category
+void loadAllEvents(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others,
+                   const string& path = "events.txt") {
+    OpTimer timer(STAT_LOAD_EVENTS);
+    MappedFile inFile(path);
+    if (!inFile.isOpen()) {
+        cout << "Couldn't open the events file. Starting with an empty database." << endl;
+        return;
+    }
+
+    // Reloading replaces whatever was in memory
+    releaseAllEvents(seminars, sports, competitions, others);
+
+    // Load events into appropriate trees, one line per event
+    string_view contents = inFile.contents();
+    vector<EventNode*> loaded[4];
+    EventNode** roots[] = {&seminars, &sports, &competitions, &others};
+    string_view segments[4];
+
+    if (splitCategorySegments(contents, segments, &snapshotCoverage.events)) {
+        eventJournal.noteSequence(snapshotCoverage.events);
+        // every category is parsed and built on its own thread, the shared indexes are filled after
+        runPerCategory([&](int i) {
+            loadEventSegment(segments[i], (EventCategory)i, loaded[i]);
+            *roots[i] = buildCategoryTree(loaded[i]);
+        });
+        eventIndex.reserve(loaded[0].size() + loaded[1].size() + loaded[2].size() + loaded[3].size());
+        for (int i = 0; i < 4; i++) {
+            for (EventNode* event : loaded[i]) indexEvent(event);
+        }
+        return;
+    }
+
+    eventIndex.reserve((size_t)count(contents.begin(), contents.end(), '\n') + 1);
+    loadEventFromFile(contents, loaded[0], loaded[1], loaded[2], loaded[3]);
+    for (int i = 0; i < 4; i++) *roots[i] = buildCategoryTree(loaded[i]);
+}
+
+void saveEventAttendees(ostream& outFile, EventNode* root) {
+    for (EventTreeIterator it(root); !it.done(); it.next()) {
+        EventNode* event = it.current();
+
+        // Write event details first
+        outFile << event->eventId << "," << event->type() << "," << event->name() << "\n";
+
+        // Then write all attendee info
+        for (const Attendee& attendee : event->attendees) {
+            outFile << attendee.fullName << "," << attendee.phoneNumber << "\n";
+        }
+        outFile << "#\n"; // Our trusty event separator
+    }
+}
+
+string serializeAttendees(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                          uint64_t journalSequence = 0) {
+    EventNode* roots[] = {seminars, sports, competitions, others};
+    string segments[4];
+    for (int i = 0; i < 4; i++) {
+        ostringstream outFile;
+        saveEventAttendees(outFile, roots[i]);
+        segments[i] = outFile.str();
+    }
+    return joinCategorySegments(segments, journalSequence);
+}
+
+// Saves participant info to keep track of who's coming!
+void saveAttendeeInfo(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    if (!writeFileAtomically("attendees.txt", serializeAttendees(seminars, sports, competitions, others))) {
+        cout << "Hey, couldn't open the attendees file. Something's not right." << endl;
+    }
+}
+
+//loads all prewritten data when the code is actually running. Each event block is an
+//"id,type,name" line, then one "name,phone" line per attendee, then "#".
+//lookup(id) finds the event a block belongs to. Blocks it can't place go to unmatched if given
+//(so a loader thread can leave them for later), otherwise they are dropped.
+template <typename Lookup>
+void loadAttendeeBlocks(string_view contents, Lookup lookup, vector<string_view>* unmatched) {
+    string_view line;
+    EventNode* event = nullptr;
+    bool inBlock = false;   // false means the next line is an event header
+
+    while (nextLine(contents, line)) {
+        if (line == "#") { // event separator
+            inBlock = false;
+            continue;
+        }
+
+        if (!inBlock) {
+            // IDs are unique across categories, so the index finds the event whatever tree it's in
+            int eventId;
+            event = parseNumber(line.substr(0, line.find(',')), eventId) ? lookup(eventId) : nullptr;
+            if (!event && unmatched) {
+                // hand the whole block back, up to and including its "#"
+                const char* blockEnd = contents.data() + contents.size();
+                string_view blockLine;
+                while (nextLine(contents, blockLine) && blockLine != "#") {}
+                if (!contents.empty()) blockEnd = contents.data();
+                unmatched->push_back(string_view(line.data(), (size_t)(blockEnd - line.data())));
+                continue;
+            }
+            inBlock = true;
+            continue;
+        }
+
+        if (!event) continue; // attendees of an event we don't have anymore
+
+        // the phone number never has a comma in it, the name might
+        size_t comma = line.rfind(',');
+        string_view attendeeName = comma == string_view::npos ? line : line.substr(0, comma);
+        string_view phoneNumber = comma == string_view::npos ? string_view() : line.substr(comma + 1);
+
+        // Add attendee to the end of the event's list, keeping the order they were saved in
+        appendAttendee(event, Attendee(string(attendeeName), string(phoneNumber)));
+    }
+}
+
+void loadAttendeeInfo(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                      const string& path = "attendees.txt") {
+    OpTimer timer(STAT_LOAD_ATTENDEES);
+    MappedFile inFile(path);
+    if (!inFile.isOpen()) {
+        cout << "Couldn't open the attendees file. No attendee data loaded." << endl;
+        return;
+    }
+
+    // the loader threads append attendees side by side, the index and snapshots are built again when next asked for
+    attendeeIndex.clear();
+    eventVersions.clear();
+
+    string_view contents = inFile.contents();
+    auto lookupAnywhere = [](int eventId) { return eventIndex.find(eventId); };
+    string_view segments[4];
+    if (!splitCategorySegments(contents, segments, &snapshotCoverage.attendees)) {
+        loadAttendeeBlocks(contents, lookupAnywhere, nullptr);
+        return;
+    }
+    eventJournal.noteSequence(snapshotCoverage.attendees);
+
+    // Each thread only searches (read-only) and fills events of its own category's tree, so they
+    // never share an event. Blocks that aren't in the tree they were saved under get placed after.
+    EventNode* roots[] = {seminars, sports, competitions, others};
+    vector<string_view> unmatched[4];
+    runPerCategory([&](int i) {
+        EventNode* root = roots[i];
+        loadAttendeeBlocks(segments[i], [root](int eventId) { return findEvent(root, eventId); }, &unmatched[i]);
+    });
+    for (int i = 0; i < 4; i++) {
+        for (string_view block : unmatched[i]) loadAttendeeBlocks(block, lookupAnywhere, nullptr);
+    }
+}
+
+// ===== Load benchmark =====
+
+// Writes a synthetic catalog, loads it a few times and reports parse throughput
+void benchmarkLoad(int eventCount) {
+    const string eventsPath = "bench_events.txt";
+    const string attendeesPath = "bench_attendees.txt";
+    const char* types[] = {"seminar", "sports", "competition", "others"};
+    {
+        ofstream events(eventsPath, ios::trunc);
+        ofstream attendees(attendeesPath, ios::trunc);
+        for (int id = 1; id <= eventCount; id++) {
+            const char* type = types[id % 4];
+            events << id << ", Event number " << id << ", " << type << ", " << (id % 3 + 1) << "\n";
+            attendees << id << "," << type << ",Event number " << id << "\n";
+            for (int a = 0; a < 3; a++) {
+                attendees << "Attendee " << id << "-" << a << ",080" << (10000000 + id * 3 + a) << "\n";
+            }
+            attendees << "#\n";
+        }
+    }
+
+    EventNode *seminars = nullptr, *sports = nullptr, *competitions = nullptr, *others = nullptr;
+
+    auto timeLoads = [&](const char* layout) {
+        ifstream eventsSize(eventsPath, ios::binary | ios::ate);
+        ifstream attendeesSize(attendeesPath, ios::binary | ios::ate);
+        double eventsMB = (double)eventsSize.tellg() / 1e6;
+        double attendeesMB = (double)attendeesSize.tellg() / 1e6;
+
+        double bestEvents = 1e30, bestAttendees = 1e30;
+        for (int run = 0; run < 3; run++) {
+            releaseAllEvents(seminars, sports, competitions, others);   // don't time tearing down the last run
+            auto start = chrono::steady_clock::now();
+            loadAllEvents(seminars, sports, competitions, others, eventsPath);
+            auto middle = chrono::steady_clock::now();
+            loadAttendeeInfo(seminars, sports, competitions, others, attendeesPath);
+            auto end = chrono::steady_clock::now();
+            bestEvents = min(bestEvents, chrono::duration<double>(middle - start).count());
+            bestAttendees = min(bestAttendees, chrono::duration<double>(end - middle).count());
+        }
+
+        cout << layout << " layout, loaded " << eventIndex.size() << " events\n"
+             << "events.txt:    " << eventsMB << " MB in " << bestEvents * 1000 << " ms, "
+             << eventsMB / bestEvents << " MB/s\n"
+             << "attendees.txt: " << attendeesMB << " MB in " << bestAttendees * 1000 << " ms, "
+             << attendeesMB / bestAttendees << " MB/s\n";
+    };
+
+    timeLoads("Single-list");
+
+    // the same catalog saved split by category, which loads one category per thread
+    writeFileAtomically(eventsPath, serializeEvents(seminars, sports, competitions, others));
+    writeFileAtomically(attendeesPath, serializeAttendees(seminars, sports, competitions, others));
+    cout << "\n";
+    timeLoads("Per-category");
+    cout << "(" << thread::hardware_concurrency() << " hardware threads)\n";
+
+    // node plus its share of the name pool plus each event's attendee storage, the attendee strings not counted
+    size_t events = eventPool.size();
+    size_t attendeeBytes = 0;
+    for (EventNode* root : {seminars, sports, competitions, others}) {
+        for (EventTreeIterator it(root); !it.done(); it.next()) {
+            EventNode* event = it.current();
+            attendeeBytes += event->attendees.capacity() * sizeof(Attendee);
+            if (event->checkInLookup) attendeeBytes += sizeof(EventNode::CheckInLookup);
+        }
+    }
+    cout << "\nMemory: " << sizeof(EventNode) << " bytes per node, "
+         << (double)eventNames.bytes() / events << " bytes per event in the name pool, "
+         << (double)attendeeBytes / events << " bytes per event of attendee storage\n";
+
+    releaseAllEvents(seminars, sports, competitions, others);
+    remove(eventsPath.c_str());
+    remove(attendeesPath.c_str());
+}
+
+
+// Basic search function with some assistance from chatgpt
+EventNode* findEvent(EventNode* root, int targetId) {
+    int depth;
+    EventNode* found = EventTree::find(root, targetId, depth);
+    instrumentation.recordSearch(depth);
+    return found; // Either the found node or nullptr
+}
+
+// ===== AVL balancing helpers =====
+// Event IDs come out of the booking system in increasing order, so a plain BST
+// degrades into a linked list. Every insert/remove rebalances on the way back up,
+// the rotations themselves are AvlBalancing in intrusive_tree.h.
+
+int nodeHeight(EventNode* node) {
+    return node ? node->height : 0;
+}
+
+/*I hardcoded event types, because ideally, the application would have a 
+dropdown box of all the type of events available to register, there is the "Other"
+available sha, just in case, but i cannot kill myself.
+
+*/
+// Makes the event out of eventPool and links it in. Callers check eventIndex first, IDs are unique.
+EventNode* insertEvent(EventNode*& root, int id, string_view name, EventCategory category, int importance) {
+    return EventTree::emplace(root, id, name, category, importance);
+}
+
+// Gives the event back to the pool, its attendees go with it. Undo history that points at it goes too.
+void releaseEvent(EventNode* event) {
+    commandManager.forgetEvent(event);
+    eventPool.destroy(event);
+}
+
+void EventPoolAllocator::destroy(EventNode* event) {
+    unindexEvent(event);
+    releaseEvent(event);
+}
+
+// Throws away every event at once for shutdown or a reload. The pool is swept
+// slab by slab so this never walks the trees.
+void releaseAllEvents(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    commandManager.clear();   // old commands point into the pools
+    eventIndex.clear();
+    frozenIdIndex.clear();
+    scheduleIndex.clear();
+    nameIndex.clear();
+    attendeeIndex.clear();
+    eventVersions.clear();
+    seminars = sports = competitions = others = nullptr;
+    eventPool.destroyAll();
+}
+
+// An event stays in the tree it was created in (or loaded into): an update can change its type
+// without moving the node, and the snapshot saves it under that same tree. So which tree holds an
+// ID is looked up, never worked out from the type. CATEGORY_COUNT if none does.
+int homeTree(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others, int id) {
+    EventNode* roots[] = {seminars, sports, competitions, others};
+    for (int c = 0; c < CATEGORY_COUNT; c++) {
+        if (findEvent(roots[c], id)) return c;
+    }
+    return CATEGORY_COUNT;
+}
+
+// chatgpt helped me here to ensure that even when i was removing events, my BST would still be balanced.
+// The node itself comes out of the tree (never a copy of its successor), so the attendees stay with it.
+EventNode* removeEvent(EventNode* root, int targetId) {
+    if (!EventTree::erase(root, targetId)) {
+        cout << "Hmm, couldn't find that event. Maybe it was already deleted?" << endl;
+    }
+    return root;
+}
+
+// ===== Report rendering =====
+
+// Collects report text in a big buffer and hands it to the stream in large chunks, never
+// flushing per line. Each section can be capped (a page size) and skip its first rows (which
+// page), anything left over is summed up in one "... more" line.
+class ReportWriter {
+private:
+    ostream& out;
+    string buffer;
+    size_t sectionLimit;   // 0 means no limit
+    size_t sectionSkip;
+    size_t sectionRows;
+    size_t sectionHidden;
+
+    static const size_t CHUNK = 1 << 16;
+
+    void spill() {
+        if (buffer.size() >= CHUNK) flush();
+    }
+
+public:
+    explicit ReportWriter(ostream& sink, size_t limitPerSection = 0, size_t skipPerSection = 0)
+        : out(sink), sectionLimit(limitPerSection), sectionSkip(skipPerSection), sectionRows(0), sectionHidden(0) {
+        buffer.reserve(CHUNK * 2);
+    }
+
+    ~ReportWriter() { flush(); }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ReportWriter& operator<<(string_view text) {
+        buffer.append(text.data(), text.size());
+        spill();
+        return *this;
+    }
+    ReportWriter& operator<<(const string& text) { return *this << string_view(text); }
+    ReportWriter& operator<<(const char* text) { return *this << string_view(text); }
+
+    ReportWriter& operator<<(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+
+    template <typename Number, typename = typename enable_if<is_integral<Number>::value>::type>
+    ReportWriter& operator<<(Number value) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+        return *this;
+    }
+
+    // Starts counting rows for a new section
+    void beginSection() {
+        sectionRows = 0;
+        sectionHidden = 0;
+    }
+
+    // Whether the next row of this section should be written, counts it either way
+    bool takeRow() {
+        size_t row = sectionRows++;
+        if (row < sectionSkip || (sectionLimit > 0 && row >= sectionSkip + sectionLimit)) {
+            sectionHidden++;
+            return false;
+        }
+        return true;
+    }
+
+    // True once the section's page is full, so callers can stop walking early
+    bool pageFull() const {
+        return sectionLimit > 0 && sectionRows >= sectionSkip + sectionLimit;
+    }
+
+    // Closes the section, saying how many rows weren't shown if any
+    void endSection(size_t rowsNotWalked = 0) {
+        size_t hidden = sectionHidden + rowsNotWalked;
+        if (hidden > 0) *this << "... " << hidden << " more not shown\n";
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), (streamsize)buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+};
+
+// Display Functions 
+
+// Works for a live event and a snapshot's copy alike, attendees is anything that iterates Attendees
+template <typename Attendees>
+void showEventDetails(ReportWriter& out, int eventId, const string& name, const char* type, int importanceLevel,
+                      const Attendees& attendees) {
+    out << "\nEvent Details:\n";
+    out << "ID: " << eventId << '\n';
+    out << "Name: " << name << '\n';
+    out << "Type: " << type << '\n';
+    out << "Importance Level: " << importanceLevel << '\n';
+    
+    if (attendees.empty()) {
+        out << "No attendees registered yet.\n";
     } else {
-        // Case 1: Leaf node 
-        if (!root->leftChild && !root->rightChild) {
-            delete root;
-            return nullptr;
+        out << "\nAttendees:\n";
+        for (const Attendee& attendee : attendees) {
+            out << "- " << attendee.fullName << " (" << attendee.phoneNumber << ")\n";
+        }
+    }
+    out << '\n';
+}
+
+void showEventDetails(ReportWriter& out, EventNode* event) {
+    showEventDetails(out, event->eventId, event->name(), event->type(), event->importanceLevel, event->attendees);
+}
+
+void showEventDetails(ReportWriter& out, const EventVersion& event) {
+    showEventDetails(out, event.eventId, event.name(), event.type(), event.importanceLevel, event.attendees());
+}
+
+void showEventDetails(EventNode* event) {
+    ReportWriter out(cout);
+    showEventDetails(out, event);
+}
+
+// Displays all events of one snapshot tree in a nice organized way, as one section of the writer
+void showAllEvents(ReportWriter& out, const VersionTree& tree, size_t eventCount) {
+    out.beginSection();
+    size_t walked = 0;
+    for (VersionIterator it(tree); !it.done() && !out.pageFull(); it.next()) {
+        walked++;
+        if (out.takeRow()) showEventDetails(out, it.current());
+    }
+    out.endSection(eventCount - walked);
+}
+
+// A snapshot's events bucketed by importance level (1-3, out of range goes to the nearest end),
+// each bucket in ID order the same as the live schedule
+void scheduleLevels(const CatalogVersion& catalog, vector<const EventVersion*> levels[3]) {
+    for (int c = 0; c < CATEGORY_COUNT; c++) {
+        size_t middle[3];
+        for (int level = 0; level < 3; level++) middle[level] = levels[level].size();
+        for (VersionIterator it(catalog.trees[c]); !it.done(); it.next()) {
+            const EventVersion& event = it.current();
+            levels[min(max(event.importanceLevel, 1), 3) - 1].push_back(&event);
+        }
+        // each tree adds a run that's already sorted, merge it in
+        for (int level = 0; level < 3; level++) {
+            inplace_merge(levels[level].begin(), levels[level].begin() + middle[level], levels[level].end(),
+                          [](const EventVersion* a, const EventVersion* b) { return a->eventId < b->eventId; });
+        }
+    }
+}
+
+// Shows the schedule off a snapshot, most important level number first, then by ID
+void displaySchedule(const CatalogVersion& catalog, ReportWriter& out) {
+    OpTimer timer(STAT_SCHEDULE);
+    vector<const EventVersion*> levels[3];
+    scheduleLevels(catalog, levels);
+    if (levels[0].empty() && levels[1].empty() && levels[2].empty()) {
+        out << "No events scheduled yet!\n";
+        return;
+    }
+
+    out << "\n=== Event Schedule ===\n";
+    out.beginSection();
+    for (int level = 3; level >= 1; level--) {
+        for (const EventVersion* event : levels[level - 1]) {
+            if (!out.takeRow()) continue;
+            out << "Priority " << event->importanceLevel << ": " 
+                << event->name() << " (" << event->type() << ")\n";
+        }
+    }
+    out.endSection();
+}
+
+void displaySchedule(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    CatalogSnapshot snapshot = takeSnapshot(seminars, sports, competitions, others);
+    ReportWriter out(cout);
+    displaySchedule(*snapshot, out);
+}
+
+// ===== Check-in history =====
+// Every accepted check-in is kept, on disk and in memory, as three columns: when they got to
+// the desk (seconds since 1970), the event, and who, as an ID into a table of attendee names.
+// checkins.log is a run of blocks, one per batch processed, each one
+//   uint32 rows | int64 time x rows | int32 event ID x rows | int32 attendee ID x rows
+// in this machine's byte order, and line n of checkins.names is the name of attendee n.
+// A row with attendee ID -1 means the event was removed then: every row of that event before it
+// is dropped, so an event made later with the same ID starts with no arrivals.
+// New names are written (and synced to disk) before the block that first uses them, and each block
+// is synced before record() returns, so a crash can only leave a torn last block (or name), which
+// is cut off the next time the history is loaded.
+// In memory the rows are filed by minute, so "who came in between T1 and T2" only looks at the
+// minutes in between, and every event keeps running totals and its arrivals per minute.
+
+string formatTime(int64_t seconds) {
+    // got this ENTIRELY from claudeAI
+    // (the _r/_s versions, several desks can be stamping at once)
+    time_t when = (time_t)seconds;
+    char stamp[32];
+#if defined(__unix__) || defined(__APPLE__)
+    ctime_r(&when, stamp);
+#else
+    ctime_s(stamp, sizeof(stamp), &when);
+#endif
+    string text = stamp;
+    return text.substr(0, text.length() - 1);  // Remove newline
+}
+
+int64_t secondsNow() {
+    return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct Arrival {
+    int64_t time;
+    int eventId;
+    string attendeeName;
+};
+
+// What the report shows per event, kept up to date as check-ins are logged
+struct CheckInTotals {
+    int eventId;
+    uint32_t arrived;
+    int64_t first;
+    int64_t last;
+};
+
+class CheckInHistory {
+private:
+    struct EventArrivals {
+        CheckInTotals totals;
+        map<int64_t, uint32_t> perMinute;   // minute -> arrivals in it
+        vector<uint32_t> rows;
+    };
+
+    string logPath, namesPath;
+    ofstream logOut, namesOut;
+    int logSyncFd, namesSyncFd;   // like EventJournal's, for syncFile after each append
+    mutable mutex lock;   // desks checking people in side by side, reports reading the totals
+
+    // the columns, row n of each is the nth check-in logged
+    vector<int64_t> times;
+    vector<int32_t> eventIds;
+    vector<int32_t> attendeeIds;
+
+    vector<string> attendeeNames;
+    unordered_map<string, int32_t> attendeeLookup;
+
+    map<int64_t, vector<uint32_t>> rowsByMinute;
+    unordered_map<int, EventArrivals> byEvent;
+    size_t droppedRows = 0;
+
+    static constexpr size_t ROW_BYTES = sizeof(int64_t) + 2 * sizeof(int32_t);
+    static constexpr int32_t EVENT_REMOVED = -1;   // in the attendee column, see above
+
+    static int64_t minuteOf(int64_t seconds) {
+        return seconds / 60 - (seconds % 60 < 0 ? 1 : 0);
+    }
+
+    // A name seen for the first time is also added to newNames, for the names file
+    int32_t internAttendee(const string& name, string& newNames) {
+        auto found = attendeeLookup.find(name);
+        if (found != attendeeLookup.end()) return found->second;
+        int32_t id = (int32_t)attendeeNames.size();
+        attendeeNames.push_back(name);
+        attendeeLookup.emplace(name, id);
+        newNames += name;
+        newNames += '\n';
+        return id;
+    }
+
+    void addRow(int64_t time, int32_t eventId, int32_t attendeeId) {
+        uint32_t row = (uint32_t)times.size();
+        times.push_back(time);
+        eventIds.push_back(eventId);
+        attendeeIds.push_back(attendeeId);
+        rowsByMinute[minuteOf(time)].push_back(row);
+
+        EventArrivals& arrivals = byEvent[eventId];
+        CheckInTotals& totals = arrivals.totals;
+        if (totals.arrived == 0) totals = CheckInTotals{eventId, 0, time, time};
+        totals.arrived++;
+        totals.first = min(totals.first, time);
+        totals.last = max(totals.last, time);
+        arrivals.perMinute[minuteOf(time)]++;
+        arrivals.rows.push_back(row);
+    }
+
+    // The rows stay where they are (the minute index points at them), marked so nobody reads them
+    void dropEvent(int eventId) {
+        auto event = byEvent.find(eventId);
+        if (event == byEvent.end()) return;
+        for (uint32_t row : event->second.rows) attendeeIds[row] = EVENT_REMOVED;
+        droppedRows += event->second.rows.size();
+        byEvent.erase(event);
+    }
+
+    void writeBlock(const char* times, const char* eventIds, const char* attendeeIds, uint32_t rows) {
+        string block(sizeof(rows) + rows * ROW_BYTES, '\0');
+        char* out = &block[0];
+        memcpy(out, &rows, sizeof(rows));
+        out += sizeof(rows);
+        memcpy(out, times, rows * sizeof(int64_t));
+        out += rows * sizeof(int64_t);
+        memcpy(out, eventIds, rows * sizeof(int32_t));
+        out += rows * sizeof(int32_t);
+        memcpy(out, attendeeIds, rows * sizeof(int32_t));
+        logOut.write(block.data(), (streamsize)block.size());
+        logOut.flush();
+        syncFile(logSyncFd);
+    }
+
+    static int openSyncFd(const string& path) {
+#ifdef HAVE_MMAP
+        return ::open(path.c_str(), O_RDONLY);
+#else
+        (void)path;
+        return -1;
+#endif
+    }
+
+    void closeSyncFds() {
+#ifdef HAVE_MMAP
+        if (logSyncFd >= 0) ::close(logSyncFd);
+        if (namesSyncFd >= 0) ::close(namesSyncFd);
+#endif
+        logSyncFd = namesSyncFd = -1;
+    }
+
+public:
+    CheckInHistory(const string& log, const string& names)
+        : logPath(log), namesPath(names), logSyncFd(-1), namesSyncFd(-1) {}
+    ~CheckInHistory() { closeSyncFds(); }
+
+    // Reads back whatever was logged before and returns how many check-ins that was
+    size_t load() {
+        lock_guard<mutex> guard(lock);
+        MappedFile names(namesPath);
+        if (names.isOpen()) {
+            // a last name with no newline was torn mid-write, nothing in the log uses it yet
+            string_view contents = names.contents();
+            string_view whole = contents.substr(0, contents.rfind('\n') + 1);
+            string_view rest = whole, line;
+            while (nextLine(rest, line)) {
+                string name(line);
+                attendeeLookup.emplace(name, (int32_t)attendeeNames.size());
+                attendeeNames.push_back(std::move(name));
+            }
+            if (whole.size() < contents.size()) writeFileAtomically(namesPath, string(whole));
+        }
+
+        MappedFile log(logPath);
+        if (!log.isOpen()) return 0;
+        string_view contents = log.contents();
+        size_t pos = 0;
+        while (contents.size() - pos >= sizeof(uint32_t)) {
+            uint32_t rows;
+            memcpy(&rows, contents.data() + pos, sizeof(rows));
+            size_t blockBytes = sizeof(rows) + (size_t)rows * ROW_BYTES;
+            if (contents.size() - pos < blockBytes) break;
+
+            const char* timeColumn = contents.data() + pos + sizeof(rows);
+            const char* eventColumn = timeColumn + (size_t)rows * sizeof(int64_t);
+            const char* attendeeColumn = eventColumn + (size_t)rows * sizeof(int32_t);
+            for (uint32_t r = 0; r < rows; r++) {
+                int64_t time;
+                int32_t eventId, attendeeId;
+                memcpy(&time, timeColumn + r * sizeof(int64_t), sizeof(time));
+                memcpy(&eventId, eventColumn + r * sizeof(int32_t), sizeof(eventId));
+                memcpy(&attendeeId, attendeeColumn + r * sizeof(int32_t), sizeof(attendeeId));
+                if (attendeeId == EVENT_REMOVED) dropEvent(eventId);
+                if (attendeeId < 0 || attendeeId >= (int32_t)attendeeNames.size()) continue;
+                addRow(time, eventId, attendeeId);
+            }
+            pos += blockBytes;
+        }
+        // new blocks have to start where the last whole one ended
+        if (pos < contents.size()) writeFileAtomically(logPath, string(contents.substr(0, pos)));
+        return times.size() - droppedRows;
+    }
+
+    void open() {
+        lock_guard<mutex> guard(lock);
+        logOut.open(logPath, ios::binary | ios::app);
+        namesOut.open(namesPath, ios::binary | ios::app);
+        if (!logOut.is_open() || !namesOut.is_open()) {
+            cout << "Couldn't open the check-in history, check-ins won't be kept after exit." << endl;
+            logOut.close();
+            return;
+        }
+        logSyncFd = openSyncFd(logPath);
+        namesSyncFd = openSyncFd(namesPath);
+        syncParentDirectory(logPath);   // either file may have just been created
+        syncParentDirectory(namesPath);
+    }
+
+    // Logs the accepted check-ins of one batch as one block. Without open() (benchmarks,
+    // trace replays) they're only kept in memory.
+    void record(const vector<const CheckIn*>& accepted) {
+        if (accepted.empty()) return;
+        lock_guard<mutex> guard(lock);
+        size_t first = times.size();
+        string newNames;
+        for (const CheckIn* checkIn : accepted) {
+            addRow(checkIn->timestamp, checkIn->eventId, internAttendee(checkIn->attendeeName, newNames));
+        }
+        if (!logOut.is_open()) return;
+
+        if (!newNames.empty()) {
+            namesOut << newNames;
+            namesOut.flush();
+            syncFile(namesSyncFd);   // on disk before the block that uses them
+        }
+        writeBlock((const char*)(times.data() + first), (const char*)(eventIds.data() + first),
+                   (const char*)(attendeeIds.data() + first), (uint32_t)accepted.size());
+    }
+
+    void record(const CheckIn& checkIn) {
+        record(vector<const CheckIn*>{&checkIn});
+    }
+
+    // The event is gone, so are its arrivals. Logged as its own one-row block so they stay
+    // gone after a restart, even if the ID gets used again.
+    void forgetEvent(int eventId) {
+        lock_guard<mutex> guard(lock);
+        dropEvent(eventId);
+        if (!logOut.is_open()) return;
+        int64_t now = secondsNow();
+        int32_t id = eventId;
+        writeBlock((const char*)&now, (const char*)&id, (const char*)&EVENT_REMOVED, 1);
+    }
+
+    // Everyone who came in from `from` to `to` (seconds, both ends included), earliest first
+    vector<Arrival> arrivedBetween(int64_t from, int64_t to) const {
+        lock_guard<mutex> guard(lock);
+        vector<Arrival> found;
+        auto end = rowsByMinute.upper_bound(minuteOf(to));
+        for (auto minute = rowsByMinute.lower_bound(minuteOf(from)); minute != end; ++minute) {
+            for (uint32_t row : minute->second) {
+                if (attendeeIds[row] < 0 || times[row] < from || times[row] > to) continue;
+                found.push_back(Arrival{times[row], eventIds[row], attendeeNames[attendeeIds[row]]});
+            }
+        }
+        stable_sort(found.begin(), found.end(),
+                    [](const Arrival& a, const Arrival& b) { return a.time < b.time; });
+        return found;
+    }
+
+    // (start of the minute, arrivals) for one event, for the minutes from `from` to `to` that had any
+    vector<pair<int64_t, uint32_t>> arrivalsPerMinute(int eventId, int64_t from, int64_t to) const {
+        lock_guard<mutex> guard(lock);
+        vector<pair<int64_t, uint32_t>> minutes;
+        auto event = byEvent.find(eventId);
+        if (event == byEvent.end()) return minutes;
+        const map<int64_t, uint32_t>& perMinute = event->second.perMinute;
+        auto end = perMinute.upper_bound(minuteOf(to));
+        for (auto minute = perMinute.lower_bound(minuteOf(from)); minute != end; ++minute) {
+            minutes.push_back(make_pair(minute->first * 60, minute->second));
+        }
+        return minutes;
+    }
+
+    // Every event anyone checked in to, by ID
+    vector<CheckInTotals> totals() const {
+        lock_guard<mutex> guard(lock);
+        vector<CheckInTotals> all;
+        all.reserve(byEvent.size());
+        for (const auto& event : byEvent) all.push_back(event.second.totals);
+        sort(all.begin(), all.end(), [](const CheckInTotals& a, const CheckInTotals& b) { return a.eventId < b.eventId; });
+        return all;
+    }
+
+    // Calls visit(event ID, attendee name) for every check-in, oldest row first
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        lock_guard<mutex> guard(lock);
+        for (size_t row = 0; row < times.size(); row++) {
+            if (attendeeIds[row] >= 0) visit(eventIds[row], attendeeNames[attendeeIds[row]]);
+        }
+    }
+
+    size_t size() const {
+        lock_guard<mutex> guard(lock);
+        return times.size() - droppedRows;
+    }
+};
+
+CheckInHistory checkInHistory("checkins.log", "checkins.names");
+
+// After a restart, whoever already came through the door still can't check in twice
+void restoreCheckedIn() {
+    checkInHistory.forEach([](int eventId, const string& attendeeName) {
+        EventNode* event = eventIndex.find(eventId);
+        if (event && event->checkInLookup) event->checkInLookup->checkedInNames.insert(normalizeName(attendeeName));
+    });
+}
+
+// ===== Batch check-in =====
+
+enum CheckInStatus { CHECKED_IN, UNKNOWN_EVENT, NOT_REGISTERED, ALREADY_CHECKED_IN };
+
+struct CheckInResult {
+    CheckIn checkIn;
+    CheckInStatus status;
+};
+
+const char* checkInStatusText(CheckInStatus status) {
+    switch (status) {
+        case CHECKED_IN: return "checked in";
+        case UNKNOWN_EVENT: return "rejected, no such event";
+        case NOT_REGISTERED: return "rejected, not registered for this event";
+        case ALREADY_CHECKED_IN: return "rejected, already checked in";
+    }
+    return "";
+}
+
+// The person must be registered for the event, and they can only come through once
+CheckInStatus checkInAt(EventNode* event, const string& attendeeName) {
+    EventNode::CheckInLookup* lookup = event->checkInLookup.get();
+    string name = normalizeName(attendeeName);
+    if (!lookup || lookup->registeredNames.find(name) == lookup->registeredNames.end()) return NOT_REGISTERED;
+    if (!lookup->checkedInNames.insert(std::move(name)).second) return ALREADY_CHECKED_IN;
+    return CHECKED_IN;
+}
+
+// Validates one check-in, the event must exist too. Every step is a hash lookup.
+CheckInStatus validateCheckIn(const CheckIn& checkIn) {
+    EventNode* event = eventIndex.find(checkIn.eventId);
+    if (!event) return UNKNOWN_EVENT;
+    return checkInAt(event, checkIn.attendeeName);
+}
+
+// Drains up to maxCount queued check-ins in one go and says what happened to each of them
+vector<CheckInResult> processCheckInBatch(size_t maxCount) {
+    maxCount = min(maxCount, checkInQueue.capacity());   // never more than the ring can hold
+    vector<CheckIn> batch(maxCount);
+    size_t taken = 0;
+    while (taken < maxCount) {
+        size_t got = checkInQueue.popBatch(batch.data() + taken, maxCount - taken);
+        if (got == 0) break;
+        taken += got;
+    }
+
+    // one hash lookup each, --bench-lookup has it beating the frozen index even in batches,
+    // and it never needs a rebuild after a create or remove
+    vector<CheckInResult> results;
+    results.reserve(taken);
+    for (size_t i = 0; i < taken; i++) {
+        CheckInStatus status = validateCheckIn(batch[i]);
+        results.push_back(CheckInResult{std::move(batch[i]), status});
+    }
+
+    // the whole batch goes into the history as one block
+    vector<const CheckIn*> accepted;
+    for (const CheckInResult& result : results) {
+        if (result.status == CHECKED_IN) accepted.push_back(&result.checkIn);
+    }
+    checkInHistory.record(accepted);
+    return results;
+}
+
+// ===== Headless API =====
+// The operations behind the menu with no prompts and no printing, so they can be driven by
+// the menu, the replay driver or the benchmarks alike. They all go through the same commands,
+// indexes and journal the menu does.
+
+EventNode* findEventById(int id) {
+    OpTimer timer(STAT_FIND);
+    EventNode* event = eventIndex.find(id);
+    if (!event) timer.failed();
+    return event;
+}
+
+// found[i] = the event with ids[i], or null, all in one pass over the frozen index. Slower than
+// findEventById per ID (see --bench-lookup) and the first call after a create or remove pays
+// for a rebuild, so it's for read-only sweeps over a settled catalog, not the check-in path.
+void findEventsById(const int* ids, size_t count, EventNode** found) {
+    frozenIdIndex.findMany(ids, count, found);
+}
+
+// Returns the new event, or nullptr if the ID is taken or the type isn't one of our categories
+EventNode* createEvent(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others,
+                       int id, const string& name, const string& type, int importance) {
+    OpTimer timer(STAT_CREATE);
+    EventCategory category;
+    if (!parseCategory(type, category) || eventIndex.find(id)) {
+        timer.failed();
+        return nullptr;
+    }
+
+    EventNode** tree = categoryTree(category, seminars, sports, competitions, others);
+    EventNode* newEvent = insertEvent(*tree, id, name, category, importance);
+    indexEvent(newEvent);
+    eventJournal.recordCreate(newEvent);
+    return newEvent;
+}
+
+// Empty name/type and importance 0 keep the current value, same as the menu.
+// False if there's no such event or the type isn't one of the four.
+bool updateEvent(int id, const string& name, const string& type, int importance) {
+    OpTimer timer(STAT_UPDATE);
+    EventNode* event = eventIndex.find(id);
+    EventCategory category;
+    if (!event || (!type.empty() && !parseCategory(type, category))) {
+        timer.failed();
+        return false;
+    }
+    commandManager.executeCommand(new UpdateEventCommand(event, name, type, importance));
+    return true;
+}
+
+// Removes the event from whichever tree holds it, see homeTree
+bool removeEventById(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others, int id) {
+    OpTimer timer(STAT_REMOVE);
+    EventNode** trees[] = {&seminars, &sports, &competitions, &others};
+    int c = eventIndex.find(id) ? homeTree(seminars, sports, competitions, others, id) : CATEGORY_COUNT;
+    if (c == CATEGORY_COUNT) {
+        timer.failed();
+        return false;
+    }
+    *trees[c] = removeEvent(*trees[c], id);
+    eventJournal.recordRemove(categoryNames[c], id);
+    checkInHistory.forgetEvent(id);
+    return true;
+}
+
+// One attendee as its own undoable command (the menu groups a session into a MacroCommand instead)
+bool registerAttendee(int eventId, const string& name, const string& phone) {
+    OpTimer timer(STAT_REGISTER);
+    EventNode* event = eventIndex.find(eventId);
+    if (!event) {
+        timer.failed();
+        return false;
+    }
+    commandManager.executeCommand(new AddAttendeeCommand(event, name, phone));
+    return true;
+}
+
+struct ImportSummary {
+    bool opened = false;
+    size_t rows = 0;
+    size_t imported = 0;
+    size_t events = 0;
+    size_t duplicates = 0;     // already registered, or further up in the same file
+    size_t unknownEvent = 0;
+    size_t malformed = 0;
+};
+
+// Bulk registration from a CSV of event ID, name, phone (a header row is fine). Rows are grouped
+// by event, anyone already registered for that event (same phone number, or same name when
+// there's no number) is skipped, and the rest go in as one undoable command, journaled once.
+ImportSummary importAttendees(const string& path) {
+    OpTimer timer(STAT_IMPORT);
+    ImportSummary summary;
+    MappedFile inFile(path);
+    summary.opened = inFile.isOpen();
+    if (!summary.opened) {
+        timer.failed();
+        return summary;
+    }
+
+    // who counts as the same person
+    auto personKey = [](const string& name, const string& phone) {
+        string digits = AttendeeIndex::normalizePhone(phone);
+        return digits.empty() ? "name:" + normalizeName(name) : digits;
+    };
+
+    vector<ImportGroup> groups;
+    unordered_map<int, size_t> groupFor;            // event ID -> its group, or SIZE_MAX if there's no such event
+    vector<unordered_set<string>> registered;       // per group, everyone already in (or coming in)
+    string_view rest = inFile.contents(), line;
+    vector<string> fields;
+    bool firstRow = true;
+    while (nextLine(rest, line)) {
+        if (trimView(line).empty()) continue;
+        bool header = firstRow;
+        firstRow = false;
+        int eventId;
+        if (!splitCsvRow(line, fields) || fields.size() < 3 || !parseNumber(fields[0], eventId)) {
+            if (!header) {
+                summary.rows++;
+                summary.malformed++;
+            }
+            continue;
+        }
+        summary.rows++;
+
+        auto found = groupFor.find(eventId);
+        if (found == groupFor.end()) {
+            EventNode* event = eventIndex.find(eventId);
+            size_t group = SIZE_MAX;
+            if (event) {
+                group = groups.size();
+                groups.push_back(ImportGroup{event, {}, 0});
+                registered.emplace_back();
+                for (const Attendee& attendee : event->attendees) {
+                    registered.back().insert(personKey(attendee.fullName, attendee.phoneNumber));
+                }
+            }
+            found = groupFor.emplace(eventId, group).first;
+        }
+        if (found->second == SIZE_MAX) {
+            summary.unknownEvent++;
+            continue;
+        }
+        if (!registered[found->second].insert(personKey(fields[1], fields[2])).second) {
+            summary.duplicates++;
+            continue;
+        }
+        groups[found->second].attendees.push_back(Attendee(fields[1], fields[2]));
+        summary.imported++;
+    }
+
+    groups.erase(remove_if(groups.begin(), groups.end(), [](const ImportGroup& group) { return group.attendees.empty(); }),
+                 groups.end());
+    summary.events = groups.size();
+    if (!groups.empty()) commandManager.executeCommand(new ImportAttendeesCommand(std::move(groups)));
+    return summary;
+}
+
+// Stamps the check-in and puts it on the queue, false if the queue is full
+bool enqueueCheckIn(int eventId, const string& attendeeName) {
+    if (!checkInQueue.tryPush(CheckIn(eventId, attendeeName, secondsNow()))) return false;
+    instrumentation.raiseTo(instrumentation.queueHighWater, checkInQueue.size());
+    return true;
+}
+
+// False if there's no such event or the queue is full
+bool queueCheckIn(int eventId, const string& attendeeName) {
+    OpTimer timer(STAT_CHECKIN);
+    if (!eventIndex.find(eventId) || !enqueueCheckIn(eventId, attendeeName)) {
+        timer.failed();
+        return false;
+    }
+    return true;
+}
+
+// Takes the next person off the queue and checks them in, false if the queue was empty
+bool checkInNext(CheckInResult& result) {
+    OpTimer timer(STAT_PROCESS);
+    if (!checkInQueue.tryPop(result.checkIn)) {
+        timer.failed();
+        return false;
+    }
+    result.status = validateCheckIn(result.checkIn);
+    if (result.status == CHECKED_IN) checkInHistory.record(result.checkIn);
+    else timer.failed();
+    return true;
+}
+
+// Everyone checked in from `from` to `to` (seconds since 1970), earliest first
+vector<Arrival> checkInsBetween(int64_t from, int64_t to) {
+    OpTimer timer(STAT_HISTORY);
+    return checkInHistory.arrivedBetween(from, to);
+}
+
+// Check-ins at one event per minute over the same kind of window, minutes with nobody are left out
+vector<pair<int64_t, uint32_t>> arrivalsPerMinute(int eventId, int64_t from, int64_t to) {
+    OpTimer timer(STAT_HISTORY);
+    return checkInHistory.arrivalsPerMinute(eventId, from, to);
+}
+
+// Events in every category with lowId <= ID <= highId, in ID order
+vector<EventNode*> findEventsInRange(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                                     int lowId, int highId) {
+    OpTimer timer(STAT_RANGE);
+    return rangeQuery(seminars, sports, competitions, others, lowId, highId);
+}
+
+// Type-ahead: up to limit events whose name or one of its words starts with the text, any case
+vector<EventNode*> searchEventsByName(const string& text, size_t limit) {
+    OpTimer timer(STAT_SEARCH);
+    return nameIndex.search(text, limit);
+}
+
+// Every event someone is registered for, in ID order. Text with digits and no letters is taken
+// as a phone number, anything else as a name.
+vector<EventNode*> findRegistrations(const string& phoneOrName) {
+    OpTimer timer(STAT_LOOKUP);
+    bool hasDigit = false, hasLetter = false;
+    for (char c : phoneOrName) {
+        if (isdigit((unsigned char)c)) hasDigit = true;
+        else if (isalpha((unsigned char)c)) hasLetter = true;
+    }
+    vector<EventNode*> found = hasDigit && !hasLetter ? attendeeIndex.eventsForPhone(phoneOrName)
+                                                      : attendeeIndex.eventsForName(phoneOrName);
+    if (found.empty()) timer.failed();
+    return found;
+}
+
+// The schedule in display order, highest importance level number first, then by ID
+vector<EventNode*> collectSchedule() {
+    vector<EventNode*> schedule;
+    for (int level = 3; level >= 1; level--) {
+        for (const auto& entry : scheduleIndex.level(level)) schedule.push_back(entry.second);
+    }
+    return schedule;
+}
+
+bool undoOperation() {
+    OpTimer timer(STAT_UNDO);
+    if (commandManager.undo()) return true;
+    timer.failed();
+    return false;
+}
+
+bool redoOperation() {
+    OpTimer timer(STAT_REDO);
+    if (commandManager.redo()) return true;
+    timer.failed();
+    return false;
+}
+
+// ===== Concurrent event store =====
+// The menu serves one operator at a time. EventStore lets many front-desk clients share one
+// process, each calling in from its own thread. Locks are always taken in this order:
+//   1. the state lock, shared. The menu and the snapshot writer take it exclusively, so
+//      they never see a store call halfway through.
+//   2. one reader/writer lock per category tree. Lookups hold it shared. Changing the tree,
+//      or an event's name, type or importance, holds it exclusively. Reads in one category
+//      never wait for writes in another.
+//   3. the event's own attendeeLock, for its attendee list and check-in lookup. Desks
+//      registering people for different events of one category don't wait for each other.
+//   4. indexLock, only around the indexes, pool and undo history every category shares.
+// Events never move between trees, not even when an update changes their type.
+
+// A copy of an event's fields, so callers never hold a pointer into a tree they don't have locked
+struct EventInfo {
+    int eventId;
+    string name;
+    EventCategory category;
+    int importanceLevel;
+    size_t attendeeCount;
+};
+
+class EventStore {
+private:
+    EventNode** roots[CATEGORY_COUNT];   // the same trees main() works on
+    mutable shared_mutex treeLocks[CATEGORY_COUNT];
+
+    // Which tree the event is in, CATEGORY_COUNT if none. The caller holds the state lock.
+    int treeHolding(int eventId) const {
+        for (int c = 0; c < CATEGORY_COUNT; c++) {
+            shared_lock<shared_mutex> tree(treeLocks[c]);
+            if (findEvent(*roots[c], eventId)) return c;
         }
-        
-        // Case 2: One child 
-        if (!root->leftChild) {
-            EventNode* temp = root->rightChild;
-            delete root;
-            return temp;
+        return CATEGORY_COUNT;
+    }
+
+    // Runs use(event) with the event's tree locked shared, false if there's no such event
+    template <typename Use>
+    bool withEvent(int eventId, Use use) const {
+        shared_lock<shared_mutex> state(snapshotWriter.stateMutex());
+        for (int c = 0; c < CATEGORY_COUNT; c++) {
+            shared_lock<shared_mutex> tree(treeLocks[c]);
+            if (EventNode* event = findEvent(*roots[c], eventId)) {
+                use(event);
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    EventStore(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others)
+        : roots{&seminars, &sports, &competitions, &others} {}
+
+    EventStore(const EventStore&) = delete;
+    EventStore& operator=(const EventStore&) = delete;
+
+    bool find(int eventId, EventInfo& info) const {
+        OpTimer timer(STAT_FIND);
+        bool found = withEvent(eventId, [&info](EventNode* event) {
+            lock_guard<mutex> attendees(event->attendeeLock);
+            info = EventInfo{event->eventId, event->name(), event->category, event->importanceLevel,
+                             event->attendees.size()};
+        });
+        if (!found) timer.failed();
+        return found;
+    }
+
+    // A copy of the event's attendee list, in registration order
+    bool attendees(int eventId, vector<Attendee>& list) const {
+        return withEvent(eventId, [&list](EventNode* event) {
+            lock_guard<mutex> attendees(event->attendeeLock);
+            list = event->attendees;
+        });
+    }
+
+    // False if the ID is taken in any category or the type isn't one of the four
+    bool create(int eventId, const string& name, const string& type, int importance) {
+        OpTimer timer(STAT_CREATE);
+        EventCategory category;
+        if (!parseCategory(type, category)) {
+            timer.failed();
+            return false;
+        }
+        shared_lock<shared_mutex> state(snapshotWriter.stateMutex());
+        unique_lock<shared_mutex> tree(treeLocks[category]);
+        lock_guard<mutex> indexes(indexLock);
+        if (eventIndex.find(eventId)) {   // only changes under indexLock, so nobody can slip the same ID in
+            timer.failed();
+            return false;
+        }
+        EventNode* newEvent = insertEvent(*roots[category], eventId, name, category, importance);
+        indexEvent(newEvent);
+        eventJournal.recordCreate(newEvent);
+        return true;
+    }
+
+    // Same rules as updateEvent(): empty name/type and importance 0 keep what's there.
+    // Journaled, but not on the menu's undo history.
+    bool update(int eventId, const string& name, const string& type, int importance) {
+        OpTimer timer(STAT_UPDATE);
+        EventCategory category;
+        if (!type.empty() && !parseCategory(type, category)) {
+            timer.failed();
+            return false;
+        }
+        shared_lock<shared_mutex> state(snapshotWriter.stateMutex());
+        int c = treeHolding(eventId);
+        if (c == CATEGORY_COUNT) {
+            timer.failed();
+            return false;
+        }
+        unique_lock<shared_mutex> tree(treeLocks[c]);
+        EventNode* event = findEvent(*roots[c], eventId);
+        if (!event) {   // removed while we switched locks
+            timer.failed();
+            return false;
+        }
+        lock_guard<mutex> indexes(indexLock);
+        UpdateEventCommand change(event, name, type, importance);
+        change.execute();
+        eventJournal.recordCommand(change);
+        return true;
+    }
+
+    bool remove(int eventId) {
+        OpTimer timer(STAT_REMOVE);
+        shared_lock<shared_mutex> state(snapshotWriter.stateMutex());
+        int c = treeHolding(eventId);
+        if (c == CATEGORY_COUNT) {
+            timer.failed();
+            return false;
+        }
+        unique_lock<shared_mutex> tree(treeLocks[c]);
+        if (!findEvent(*roots[c], eventId)) {
+            timer.failed();
+            return false;
+        }
+        lock_guard<mutex> indexes(indexLock);
+        *roots[c] = removeEvent(*roots[c], eventId);
+        eventJournal.recordRemove(categoryNames[c], eventId);
+        checkInHistory.forgetEvent(eventId);
+        return true;
+    }
+
+    // Journaled, but not on the menu's undo history
+    bool registerAttendee(int eventId, const string& name, const string& phone) {
+        OpTimer timer(STAT_REGISTER);
+        bool found = withEvent(eventId, [&](EventNode* event) {
+            lock_guard<mutex> attendees(event->attendeeLock);
+            appendAttendee(event, Attendee(name, phone));
+            // still under the event's lock, so the journal has its attendees in list order.
+            // Other desks on this event sleep on the mutex meanwhile, different events go on.
+            eventJournal.recordAttendee(eventId, event->attendees.back());
+        });
+        if (!found) timer.failed();
+        return found;
+    }
+
+    bool queueCheckIn(int eventId, const string& attendeeName) {
+        OpTimer timer(STAT_CHECKIN);
+        shared_lock<shared_mutex> state(snapshotWriter.stateMutex());
+        if (treeHolding(eventId) == CATEGORY_COUNT || !enqueueCheckIn(eventId, attendeeName)) {
+            timer.failed();
+            return false;
         }
-        if (!root->rightChild) {
-            EventNode* temp = root->leftChild;
-            delete root;
-            return temp;
+        return true;
+    }
+
+    // Takes the next person off the queue and checks them in, false if the queue was empty
+    bool checkInNext(CheckInResult& result) {
+        OpTimer timer(STAT_PROCESS);
+        if (!checkInQueue.tryPop(result.checkIn)) {
+            timer.failed();
+            return false;
+        }
+        result.status = UNKNOWN_EVENT;
+        withEvent(result.checkIn.eventId, [&result](EventNode* event) {
+            lock_guard<mutex> attendees(event->attendeeLock);
+            result.status = checkInAt(event, result.checkIn.attendeeName);
+        });
+        if (result.status == CHECKED_IN) checkInHistory.record(result.checkIn);
+        else timer.failed();
+        return true;
+    }
+};
+
+// ===== Concurrent store benchmark =====
+
+// Front-desk traffic from 1, 2, 4... threads at once against one EventStore: mostly lookups,
+// then registrations, check-ins, the odd update and short-lived events being created and
+// removed. Reports total throughput and how it scales against one thread. Only runs with no
+// more threads than the machine has cores say anything about scaling, the rest are marked.
+void benchmarkStore(int eventCount, const vector<int>& threadCounts) {
+    const int OPS_PER_THREAD = 200000;
+    const char* types[] = {"seminar", "sports", "competition", "others"};
+    EventNode *seminars = nullptr, *sports = nullptr, *competitions = nullptr, *others = nullptr;
+    EventStore store(seminars, sports, competitions, others);
+    for (int id = 1; id <= eventCount; id++) store.create(id, "Event " + to_string(id), types[id % 4], id % 3 + 1);
+
+    cout << "(" << thread::hardware_concurrency() << " hardware threads, " << eventCount << " events, "
+         << OPS_PER_THREAD << " operations per thread)\n";
+    unsigned cores = thread::hardware_concurrency();
+    cout << "threads        ops/sec   speedup\n";
+    double perThread = 0;   // of the first run, what the speedup is measured against
+    for (int threadCount : threadCounts) {
+        vector<thread> threads;
+        auto start = chrono::steady_clock::now();
+        for (int t = 0; t < threadCount; t++) {
+            threads.emplace_back([&store, &types, eventCount, t]() {
+                mt19937 random(1000 + t);
+                EventInfo info;
+                CheckInResult result;
+                int ownId = eventCount + 1 + t;   // IDs no other thread uses, for the create/remove pairs
+                for (int i = 0; i < OPS_PER_THREAD; i++) {
+                    int id = (int)(random() % eventCount) + 1;
+                    int pick = (int)(random() % 100);
+                    if (pick < 60) {
+                        store.find(id, info);
+                    } else if (pick < 80) {
+                        store.registerAttendee(id, "Guest " + to_string(i), "080" + to_string(10000000 + i));
+                    } else if (pick < 89) {
+                        store.queueCheckIn(id, "Guest " + to_string(i));
+                    } else if (pick < 98) {
+                        store.checkInNext(result);
+                    } else if (pick < 99) {
+                        store.update(id, "", "", (int)(random() % 3) + 1);
+                    } else if (!store.remove(ownId)) {
+                        store.create(ownId, "Pop-up", types[random() % 4], 2);
+                    }
+                }
+                store.remove(ownId);
+            });
         }
+        for (thread& worker : threads) worker.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double throughput = (double)threadCount * OPS_PER_THREAD / seconds;
+        if (perThread == 0) perThread = throughput / threadCount;
+        printf("%7d %14.0f %9.2f%s\n", threadCount, throughput, throughput / perThread,
+               cores > 0 && (unsigned)threadCount > cores ? "   (more threads than cores)" : "");
+    }
+    if (cores <= 1) cout << "Only one hardware thread here, so this can't show scaling. Run it on a multi-core machine.\n";
+    CheckInResult leftover;
+    while (store.checkInNext(leftover)) {}
+    releaseAllEvents(seminars, sports, competitions, others);
+}
+
+// ===== User Interface Functions =====
+// Each action asks for everything first and takes the state lock only for the lookups and the
+// change itself, so the snapshot writer and EventStore callers never wait on someone typing.
+
+unique_lock<shared_mutex> lockState() {
+    return unique_lock<shared_mutex>(snapshotWriter.stateMutex());
+}
+
+void createNewEvent(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    string name, type;
+    int importance, id;
+
+    cin.ignore();
+    cout << "Event name: ";
+    getline(cin, name);
+
+    cout << "Event type (Seminar/Sports/Competition/Others): ";
+    getline(cin, type);
+    string tolower(type);
+    transform(type.begin(), type.end(), type.begin(), ::tolower);
+
+    cout << "Importance level (1-3): ";
+    cin >> importance;
+
+    // Make sure we don't duplicate IDs
+    bool uniqueId = false;
+    while (!uniqueId) {
+        cout << "Event ID: ";
+        cin >> id;
         
-        // Case 3: Two children - chatgpt helped here, deleting a parent node without affecting the children node
-        EventNode* successor = findMinNode(root->rightChild);
-        root->eventId = successor->eventId;
-        root->eventName = successor->eventName;
-        root->eventType = successor->eventType;
-        root->importanceLevel = successor->importanceLevel;
-        root->rightChild = removeEvent(root->rightChild, successor->eventId);
+        auto state = lockState();
+        if (!eventIndex.find(id)) {
+            uniqueId = true;
+        } else {
+            cout << "That ID's taken! Try another one." << endl;
+        }
+    }
+
+    EventCategory category;
+    if (!parseCategory(type, category)) {
+        cout << "Oops! That's not a valid event type." << endl;
+        return;
+    }
+    auto state = lockState();
+    if (!createEvent(seminars, sports, competitions, others, id, name, type, importance)) {
+        cout << "Someone else just took ID " << id << ", the event wasn't created." << endl;
+        return;
+    }
+
+    cout << "Event created successfully!" << endl;
+}
+
+void updateEventInfo() {
+    int id;
+    cout << "Enter the Event ID to update: ";
+    cin >> id;
+
+    // One index lookup instead of searching all four categories
+    unique_lock<shared_mutex> state = lockState();
+    bool found = eventIndex.find(id) != nullptr;
+    state.unlock();
+
+    if (!found) {
+        cout << "Event not found!" << endl;
+        return;
+    }
+
+    // Display current details (keep your existing display code)
+    cout << "Event found!" << endl;
+    cout << "Current details:" << endl;
+    // ... (rest of your display code)
+
+    cin.ignore();
+    string name, type;
+    int importance;
+
+    // Get new details (keep your existing input code)
+    cout << "Enter new name (or press Enter to keep the current name): ";
+    getline(cin, name);
+
+    cout << "Enter new type (Seminar/Sports/Competition/Others or press Enter to keep current type): ";
+    getline(cin, type);
+    transform(type.begin(), type.end(), type.begin(), ::tolower);
+
+    cout << "Enter new importance level (1-3 or press 0 to keep current level): ";
+    cin >> importance;
+
+    // Runs as an undoable update command. It looks the event up again, it may be gone by now.
+    state.lock();
+    if (!updateEvent(id, name, type, importance)) {
+        cout << (eventIndex.find(id) ? "Oops! That's not a valid event type." : "Event not found!") << endl;
+        return;
+    }
+
+    cout << "Event updated successfully!" << endl;
+}
+
+
+void registerNewAttendee() {
+ 
+    int id;
+    cout << "Event ID: ";
+    cin >> id;
+
+    unique_lock<shared_mutex> state = lockState();
+    EventNode* event = eventIndex.find(id);
+
+    if (!event) {
+        cout << "Couldn't find that event. Double-check the ID?" << endl;
+        return;
+    }
+
+    cout << "Found event: " << event->name() << endl;
+    state.unlock();
+
+    // Everyone is asked for first and registered together at the end, as one undoable unit and
+    // one journal write. The lock is only taken to check each number against who's registered.
+    vector<Attendee> session;
+
+    char addMore;
+    do {
+        string name, phone;
+        cin.ignore();
+
+        cout << "Attendee name: ";
+        getline(cin, name);
+
+        cout << "Phone number: ";
+        getline(cin, phone);
+
+        // catch the same person being signed up twice, and mention where else they're going
+        bool alreadyHere = false;
+        string elsewhere;
+        state.lock();
+        event = eventIndex.find(id);
+        if (!event) {
+            cout << "That event was removed meanwhile, nobody was registered." << endl;
+            return;
+        }
+        for (EventNode* registeredFor : attendeeIndex.eventsForPhone(phone)) {
+            if (registeredFor == event) alreadyHere = true;
+            else elsewhere += (elsewhere.empty() ? "" : ", ") + registeredFor->name() + " (" + to_string(registeredFor->eventId) + ")";
+        }
+        state.unlock();
+        for (const Attendee& earlier : session) {
+            if (earlier.phoneNumber == phone) alreadyHere = true;
+        }
+        if (!elsewhere.empty()) cout << "That number is also registered for: " << elsewhere << endl;
+
+        char registerAnyway = 'y';
+        if (alreadyHere) {
+            cout << "That number is already registered for this event. Register again anyway? (y/n): ";
+            cin >> registerAnyway;
+        }
+
+        if (registerAnyway == 'y' || registerAnyway == 'Y') {
+            session.push_back(Attendee(name, phone));
+        } else {
+            cout << "Skipped, they're already on the list." << endl;
+        }
+
+        cout << "Register another? (y/n): ";
+        cin >> addMore;
+    } while (addMore == 'y' || addMore == 'Y');
+
+    // nothing to undo if every one of them was skipped
+    if (session.empty()) return;
+
+    state.lock();
+    event = eventIndex.find(id);
+    if (!event) {
+        cout << "That event was removed meanwhile, nobody was registered." << endl;
+        return;
+    }
+    MacroCommand* registrations = new MacroCommand();
+    for (const Attendee& attendee : session) {
+        OpTimer timer(STAT_REGISTER);
+        Command* registerCmd = new AddAttendeeCommand(event, attendee.fullName, attendee.phoneNumber);
+        registerCmd->execute();
+        registrations->addExecuted(registerCmd);
+    }
+    commandManager.commitExecuted(registrations);
+    cout << session.size() << (session.size() == 1 ? " attendee" : " attendees") << " registered successfully!" << endl;
+}
+
+
+void undoLastOperation() {
+    // the journal picks the undo up, no need to rewrite the files
+    auto state = lockState();
+    if (undoOperation()) return;
+    if (commandManager.canUndo()) cout << "Can't undo that, the attendee list has changed since." << endl;
+    else cout << "Nothing to undo!" << endl;
+}
+
+void redoLastOperation() {
+    auto state = lockState();
+    if (!redoOperation()) cout << "Nothing to redo!" << endl;
+}
+
+// Runs on the snapshot writer thread. Serializing happens under the state lock, together with
+// rotating the journal, so the snapshot and the rotated records match exactly. The slow part,
+// the disk writes, happens after the lock is released.
+bool writeSnapshot(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    OpTimer timer(STAT_SAVE);
+    string events, attendees;
+    {
+        lock_guard<shared_mutex> stateLock(snapshotWriter.stateMutex());
+        uint64_t covered = eventJournal.lastSequence();   // nothing can journal while we hold the lock
+        events = serializeEvents(seminars, sports, competitions, others, covered);
+        attendees = serializeAttendees(seminars, sports, competitions, others, covered);
+        eventJournal.rotate();
+    }
+
+    // The rotated journal is only dropped once both files are in place. After a crash before the
+    // delete its records are read again at startup, but the headers say the files hold them
+    // already so they're skipped. If only events.txt made it, the attendee records still apply.
+    if (!writeFileAtomically("events.txt", events) || !writeFileAtomically("attendees.txt", attendees)) {
+        timer.failed();
+        return false;
+    }
+    if (instrumentation.on()) instrumentation.lastSnapshotBytes.store(events.size() + attendees.size(), memory_order_relaxed);
+    eventJournal.dropRotated();
+    return true;
+}
+
+// Re-applies whatever the journal recorded since the last compaction, on top of the loaded snapshot.
+// Returns how many records were applied.
+int replayJournalFile(const string& path, EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    ifstream inFile(path);
+    if (!inFile.is_open()) return 0;
+
+    int applied = 0;
+    string line;
+    while (getline(inFile, line)) {
+        uint64_t sequence = 0;
+        if (!line.empty() && isdigit((unsigned char)line[0])) {
+            auto parsed = from_chars(line.data(), line.data() + line.size(), sequence);
+            if (parsed.ec != errc() || parsed.ptr == line.data() + line.size() || *parsed.ptr != ' ') continue;
+            line.erase(0, parsed.ptr - line.data() + 1);
+            eventJournal.noteSequence(sequence);
+        }
+        if (line.size() < 3) continue;
+        // attendee records went into attendees.txt, the rest into events.txt
+        bool attendeeRecord = line[0] == 'A' || line[0] == 'P';
+        if (sequence > 0 && sequence <= (attendeeRecord ? snapshotCoverage.attendees : snapshotCoverage.events)) continue;
+        stringstream ss(line.substr(2));
+        int eventId;
+        if (!(ss >> eventId)) continue;
+
+        // a torn last line from a crash just fails to parse and is skipped
+        if (line[0] == 'C') {
+            int importance;
+            ss >> importance;
+            size_t pos = 2 + (size_t)ss.tellg();
+            string type, name;
+            if (!readJournalField(line, pos, type) || !readJournalField(line, pos, name)) continue;
+            EventCategory category;
+            if (!parseCategory(type, category) || eventIndex.find(eventId)) continue;
+            EventNode** tree = categoryTree(category, seminars, sports, competitions, others);
+            indexEvent(insertEvent(*tree, eventId, name, category, importance));
+        } else if (line[0] == 'R') {
+            // the tree named in the record is only a hint, the event is looked up by ID like a live remove
+            EventNode** trees[] = {&seminars, &sports, &competitions, &others};
+            int c = eventIndex.find(eventId) ? homeTree(seminars, sports, competitions, others, eventId)
+                                             : CATEGORY_COUNT;
+            if (c == CATEGORY_COUNT) {
+                cout << "Journal: can't remove event " << eventId << ", there's no such event. Skipped." << endl;
+                continue;
+            }
+            *trees[c] = removeEvent(*trees[c], eventId);
+        } else if (line[0] == 'U') {
+            int importance;
+            ss >> importance;
+            size_t pos = 2 + (size_t)ss.tellg();
+            string name, type;
+            EventNode* event = eventIndex.find(eventId);
+            if (!event || !readJournalField(line, pos, name) || !readJournalField(line, pos, type)) continue;
+            renameEvent(event, name);
+            parseCategory(type, event->category);   // older journals may hold a type we don't know, that keeps the current one
+            setImportance(event, importance);
+            publishEvent(event);
+        } else if (line[0] == 'A') {
+            size_t pos = 2 + (size_t)ss.tellg();
+            string name, phone;
+            EventNode* event = eventIndex.find(eventId);
+            if (!event || !readJournalField(line, pos, name) || !readJournalField(line, pos, phone)) continue;
+            appendAttendee(event, Attendee(name, phone));
+        } else if (line[0] == 'P') {
+            // older journals don't say which one, it was always the last
+            EventNode* event = eventIndex.find(eventId);
+            if (!event || event->attendees.empty()) continue;
+            size_t position;
+            if (!(ss >> position)) position = event->attendees.size() - 1;
+            if (position >= event->attendees.size()) continue;
+            removeAttendeeAt(event, position);
+        } else {
+            continue;
+        }
+        applied++;
+    }
+    return applied;
+}
+
+// Records rotated out for a snapshot that never made it to disk come first, then the live journal
+int replayJournal(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
+    return replayJournalFile(eventJournal.fileName() + ".old", seminars, sports, competitions, others)
+         + replayJournalFile(eventJournal.fileName(), seminars, sports, competitions, others);
+}
+
+void processCheckIn(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    int eventId;
+    string attendeeName;
+    
+    cout << "Enter Event ID: ";
+    cin >> eventId;
+    cin.ignore();
+
+    unique_lock<shared_mutex> state = lockState();
+    EventNode* event = findEventById(eventId);
+    if (!event) {
+        cout << "No event with that ID, check-in not queued.\n";
+        return;
+    }
+    cout << "Checking in to: " << event->name() << "\n";
+    state.unlock();
+    cout << "Enter Attendee Name: ";
+    getline(cin, attendeeName);
+    
+    state.lock();
+    if (!queueCheckIn(eventId, attendeeName)) {
+        cout << "The check-in queue is full or the event is gone, check-in not queued.\n";
+        return;
+    }
+    cout << "Check-in queued successfully!\n";
+}
+
+void processCheckInQueueBatch() {
+    // read as text so a typo or a negative number gets a message instead of a huge allocation
+    string typed;
+    cout << "How many check-ins to process? ";
+    cin >> typed;
+    long long count = 0;
+    auto parsed = from_chars(typed.data(), typed.data() + typed.size(), count);
+    if (parsed.ec == errc::result_out_of_range && !typed.empty() && typed[0] != '-') count = LLONG_MAX;
+    else if (parsed.ec != errc() || parsed.ptr != typed.data() + typed.size() || count <= 0) {
+        cout << "Please enter a whole number above 0.\n";
+        return;
+    }
+
+    auto state = lockState();
+    vector<CheckInResult> results = processCheckInBatch((size_t)min<long long>(count, (long long)checkInQueue.size()));
+    if (results.empty()) {
+        cout << "No one in the check-in queue.\n";
+        return;
+    }
+
+    size_t accepted = 0;
+    for (const CheckInResult& result : results) {
+        if (result.status == CHECKED_IN) accepted++;
+        cout << result.checkIn.attendeeName << " (event " << result.checkIn.eventId << "): "
+             << checkInStatusText(result.status) << "\n";
+    }
+    cout << accepted << " of " << results.size() << " check-ins accepted.\n";
+}
+
+//actually checks people in into the event
+void processNextCheckIn() {
+    auto state = lockState();
+    CheckInResult result;
+    if (!checkInNext(result)) {
+        cout << "No one in the check-in queue.\n";
+        return;
+    }
+    
+    const CheckIn& next = result.checkIn;
+    cout << "Processing check-in for:\n"
+         << "Attendee: " << next.attendeeName << "\n"
+         << "Event ID: " << next.eventId << "\n"
+         << "Check-in Time: " << formatTime(next.timestamp) << "\n"
+         << "Result: " << checkInStatusText(result.status) << "\n";
+}
+
+// View next person in line
+void viewNextInLine() {
+    auto state = lockState();
+    CheckIn next;
+    if (!checkInQueue.peek(next)) {
+        cout << "No one in the check-in queue.\n";
+        return;
+    }
+    
+    cout << "Next in line:\n"
+         << "Attendee: " << next.attendeeName << "\n"
+         << "Event ID: " << next.eventId << "\n";
+}
+
+// Who came in over the last few minutes, for one event or all of them
+void showCheckInHistory() {
+    int eventId, minutes;
+    cout << "Event ID (0 for every event): ";
+    cin >> eventId;
+    cout << "Over the last how many minutes? ";
+    cin >> minutes;
+
+    int64_t to = secondsNow();
+    int64_t from = to - (int64_t)max(minutes, 0) * 60;
+    if (eventId != 0) {
+        vector<pair<int64_t, uint32_t>> perMinute = arrivalsPerMinute(eventId, from, to);
+        if (perMinute.empty()) {
+            cout << "Nobody checked in to event " << eventId << " in that time.\n";
+            return;
+        }
+        cout << "Check-ins per minute:\n";
+        for (const auto& minute : perMinute) {
+            cout << "  " << formatTime(minute.first) << ": " << minute.second << "\n";
+        }
+    }
+
+    size_t shown = 0;
+    for (const Arrival& arrival : checkInsBetween(from, to)) {
+        if (eventId != 0 && arrival.eventId != eventId) continue;
+        if (shown++ == 0) cout << "Checked in:\n";
+        cout << "  " << formatTime(arrival.time) << "  " << arrival.attendeeName
+             << " (event " << arrival.eventId << ")\n";
     }
-    return root;
+    if (shown == 0) cout << "Nobody checked in in that time.\n";
 }
 
-// Display Functions 
+// ===== Check-in queue benchmark =====
 
-void showEventDetails(EventNode* event) {
-    cout << "\nEvent Details:" << endl;
-    cout << "ID: " << event->eventId << endl;
-    cout << "Name: " << event->eventName << endl;
-    cout << "Type: " << event->eventType << endl;
-    cout << "Importance Level: " << event->importanceLevel << endl;
-    
-    if (!event->attendeeList) {
-        cout << "No attendees registered yet.\n";
-    } else {
-        cout << "\nAttendees:" << endl;
-        Attendee* current = event->attendeeList;
-        while (current) {
-            cout << "- " << current->fullName << " (" << current->phoneNumber << ")\n";
-            current = current->nextAttendee;
+// Pushes `total` check-ins through a fresh ring with several kiosks (producers) and staff
+// stations (consumers) at once and reports check-ins per second for each combination
+void benchmarkCheckIns(int total) {
+    const int counts[] = {1, 2, 4, 8};
+    const size_t BATCH = 64;
+
+    cout << "producers consumers  check-ins/sec\n";
+    for (int producers : counts) {
+        for (int consumers : counts) {
+            CheckInRing<CheckIn> ring(1024);
+            atomic<int> consumed(0);
+            vector<thread> threads;
+
+            auto start = chrono::steady_clock::now();
+            for (int p = 0; p < producers; p++) {
+                threads.emplace_back([&, p]() {
+                    int share = total / producers + (p < total % producers ? 1 : 0);
+                    for (int i = 0; i < share; i++) {
+                        CheckIn checkIn(i, "Guest", 0);
+                        while (!ring.tryPush(checkIn)) this_thread::yield();
+                    }
+                });
+            }
+            for (int c = 0; c < consumers; c++) {
+                threads.emplace_back([&]() {
+                    CheckIn batch[BATCH];
+                    while (consumed.load(memory_order_relaxed) < total) {
+                        size_t taken = ring.popBatch(batch, BATCH);
+                        if (taken == 0) {
+                            this_thread::yield();
+                            continue;
+                        }
+                        consumed.fetch_add((int)taken, memory_order_relaxed);
+                    }
+                });
+            }
+            for (thread& worker : threads) worker.join();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            cout << "  " << producers << "         " << consumers << "        "
+                 << (long long)(total / seconds) << "\n";
         }
     }
-    cout << endl;
 }
 
-// Displays all events in a nice organized way
-void showAllEvents(EventNode* root) {
-    if (root) {
-        showAllEvents(root->leftChild);
-        showEventDetails(root);
-        showAllEvents(root->rightChild);
+
+// ===== Lookup benchmark =====
+
+// Random lookups by ID (nine in ten hit) through the pointer tree of the right category, the
+// hash index, and the frozen index one at a time and in batches. Prints nanoseconds per lookup.
+void benchmarkLookups(const vector<int>& eventCounts) {
+    const int LOOKUPS = 2000000;
+    const size_t BATCH = 256;
+    const char* types[] = {"seminar", "sports", "competition", "others"};
+    EventNode *seminars = nullptr, *sports = nullptr, *competitions = nullptr, *others = nullptr;
+    EventNode** roots[] = {&seminars, &sports, &competitions, &others};
+    mt19937 rng(12345);
+
+    cout << "events      tree ns    hash ns  frozen ns   batch ns   rebuild ms\n";
+    for (int eventCount : eventCounts) {
+        releaseAllEvents(seminars, sports, competitions, others);
+
+        // sparse IDs in random order, so the trees aren't built from sorted input
+        vector<int> ids(eventCount);
+        for (int i = 0; i < eventCount; i++) ids[i] = i * 8 + 1 + (int)(rng() % 7);
+        shuffle(ids.begin(), ids.end(), rng);
+        for (int id : ids) createEvent(seminars, sports, competitions, others, id, "Event", types[id % 4], 2);
+
+        vector<int> wanted(LOOKUPS);
+        for (int& id : wanted) id = rng() % 10 ? ids[rng() % ids.size()] : (int)(rng() % ((uint32_t)eventCount * 8));
+
+        auto start = chrono::steady_clock::now();
+        auto elapsed = [&start]() {
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            start = chrono::steady_clock::now();
+            return seconds;
+        };
+        size_t hits[4] = {0, 0, 0, 0};
+        double nanos[4];
+
+        for (int id : wanted) hits[0] += findEvent(*roots[id % 4], id) != nullptr;
+        nanos[0] = elapsed() * 1e9 / LOOKUPS;
+        for (int id : wanted) hits[1] += eventIndex.find(id) != nullptr;
+        nanos[1] = elapsed() * 1e9 / LOOKUPS;
+
+        frozenIdIndex.find(0);   // the first lookup after the creates rebuilds it
+        double rebuildMs = elapsed() * 1e3;
+        for (int id : wanted) hits[2] += frozenIdIndex.find(id) != nullptr;
+        nanos[2] = elapsed() * 1e9 / LOOKUPS;
+        vector<EventNode*> found(BATCH);
+        for (size_t at = 0; at < wanted.size(); at += BATCH) {
+            size_t count = min(BATCH, wanted.size() - at);
+            findEventsById(&wanted[at], count, found.data());
+            for (size_t i = 0; i < count; i++) hits[3] += found[i] != nullptr;
+        }
+        nanos[3] = elapsed() * 1e9 / LOOKUPS;
+
+        char row[128];
+        snprintf(row, sizeof(row), "%-9d %9.1f %10.1f %10.1f %10.1f %12.1f%s\n", eventCount, nanos[0], nanos[1],
+                 nanos[2], nanos[3], rebuildMs,
+                 hits[0] == hits[1] && hits[1] == hits[2] && hits[2] == hits[3] ? "" : "   (results differ!)");
+        cout << row;
     }
+    releaseAllEvents(seminars, sports, competitions, others);
 }
 
-// This is where Claude's help came in handy - helped me sort events by importance
-void displaySchedule(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
-    vector<EventNode*> allEvents;
-    
-    // Helper lambda to collect all events, this allows us modify variables form outside functions (in this case allEvents)
-    //gives permission tot the function to modify our table during in-order traversal
-    auto collectEvents = [&](EventNode* node, auto& collect) -> void {
-        if (node) {
-            collect(node->leftChild, collect);
-            allEvents.push_back(node);
-            collect(node->rightChild, collect);
-        }
-    };
 
-    // Gather all events from each category
-    collectEvents(seminars, collectEvents);
-    collectEvents(sports, collectEvents);
-    collectEvents(competitions, collectEvents);
-    collectEvents(others, collectEvents);
+// ===== Statistics =====
 
-    if (allEvents.empty()) {
-        cout << "No events scheduled yet!" << endl;
-        return;
+struct CategoryGauges {
+    const char* name;
+    size_t events;
+    int height;
+    size_t attendees;
+};
+
+void measureTree(EventNode* root, size_t& events, size_t& attendees) {
+    for (EventTreeIterator it(root); !it.done(); it.next()) {
+        events++;
+        attendees += it.current()->attendees.size();
     }
+}
 
-    // Sort by importance level (high to low) and ID (for ties)
-    sort(allEvents.begin(), allEvents.end(), [](EventNode* a, EventNode* b) {
-        return a->importanceLevel != b->importanceLevel ? 
-               a->importanceLevel > b->importanceLevel : 
-               a->eventId < b->eventId;
-    });
+// Sizes are counted on demand, only the report and the dump need them
+vector<CategoryGauges> categoryGauges(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    EventNode* roots[] = {seminars, sports, competitions, others};
+    const char* names[] = {"seminars", "sports", "competitions", "others"};
+    vector<CategoryGauges> gauges;
+    for (int i = 0; i < 4; i++) {
+        CategoryGauges category{names[i], 0, nodeHeight(roots[i]), 0};
+        measureTree(roots[i], category.events, category.attendees);
+        gauges.push_back(category);
+    }
+    return gauges;
+}
 
-    cout << "\n=== Event Schedule ===" << endl;
-    for (auto event : allEvents) {
-        cout << "Priority " << event->importanceLevel << ": " 
-             << event->eventName << " (" << event->eventType << ")" << endl;
+// A snapshot keeps its counts up to date, so these cost nothing
+vector<CategoryGauges> categoryGauges(const CatalogVersion& catalog) {
+    const char* names[] = {"seminars", "sports", "competitions", "others"};
+    vector<CategoryGauges> gauges;
+    for (int i = 0; i < CATEGORY_COUNT; i++) {
+        gauges.push_back(CategoryGauges{names[i], catalog.eventCounts[i],
+                                        catalog.trees[i] ? catalog.trees[i]->height : 0, catalog.attendeeCounts[i]});
     }
+    return gauges;
 }
 
-// ===== User Interface Functions =====
+int deepestSearch() {
+    for (int depth = Instrumentation::MAX_DEPTH - 1; depth > 0; depth--) {
+        if (instrumentation.searchDepths[depth].load(memory_order_relaxed)) return depth;
+    }
+    return 0;
+}
 
-void createNewEvent(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
-    string name, type;
-    int importance, id;
+// Takes the gauges rather than the trees so a report can print them from its snapshot
+void printStatistics(const vector<CategoryGauges>& gauges, ostream& out) {
+    if (!instrumentation.on()) out << "(instrumentation is switched off, only the gauges are live)\n";
 
-    cin.ignore();
-    cout << "Event name: ";
-    getline(cin, name);
+    size_t events = 0;
+    for (const CategoryGauges& category : gauges) {
+        out << category.name << ": " << category.events << " events, tree height " << category.height
+            << ", " << category.attendees << " attendees\n";
+        events += category.events;
+    }
+    out << "Check-in queue: " << checkInQueue.size() << " of " << checkInQueue.capacity()
+        << ", high-water " << instrumentation.queueHighWater.load() << "\n";
 
-    cout << "Event type (Seminar/Sports/Competition/Others): ";
-    getline(cin, type);
-    string tolower(type);
-    transform(type.begin(), type.end(), type.begin(), ::tolower);
+    uint64_t searches = instrumentation.searches.load();
+    out << "Tree searches: " << searches << ", average depth "
+        << (searches ? (double)instrumentation.searchNodesVisited.load() / searches : 0.0)
+        << ", deepest " << deepestSearch() << "\n";
+    out << "Event nodes: " << events << " of " << sizeof(EventNode) << " bytes, "
+        << eventNames.size() << " distinct names\n";
+    out << "Journal records: " << instrumentation.journalRecords.load()
+        << ", bytes written: " << instrumentation.bytesWritten.load()
+        << ", last snapshot: " << instrumentation.lastSnapshotBytes.load() << " bytes\n";
 
-    cout << "Importance level (1-3): ";
-    cin >> importance;
+    out << "operation          count   failed    avg us    p50 us    p99 us    max us\n";
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        const LatencyHistogram& histogram = instrumentation.latency[op];
+        uint64_t count = histogram.count.load();
+        if (count == 0) continue;
+        char row[128];
+        snprintf(row, sizeof(row), "%-16s %7llu %8llu %9.2f %9.2f %9.2f %9.2f\n", statOpNames[op],
+                 (unsigned long long)count, (unsigned long long)instrumentation.failures[op].load(),
+                 histogram.totalNs.load() / 1000.0 / count, histogram.percentileNs(0.50) / 1000.0,
+                 histogram.percentileNs(0.99) / 1000.0, histogram.maxNs.load() / 1000.0);
+        out << row;
+    }
+}
 
-    // Make sure we don't duplicate IDs
-    bool uniqueId = false;
-    while (!uniqueId) {
-        cout << "Event ID: ";
-        cin >> id;
-        
-        if (!findEvent(seminars, id) && !findEvent(sports, id) && !findEvent(competitions, id) && !findEvent(others, id)) {
-            uniqueId = true;
-        } else {
-            cout << "That ID's taken! Try another one." << endl;
-        }
+// The same numbers as one JSON object, with the raw histogram buckets, for scripts to pick up
+void dumpStatistics(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others, ostream& out) {
+    out << "{\n  \"enabled\": " << (instrumentation.on() ? "true" : "false") << ",\n  \"categories\": {";
+    bool first = true;
+    for (const CategoryGauges& category : categoryGauges(seminars, sports, competitions, others)) {
+        out << (first ? "\n" : ",\n") << "    \"" << category.name << "\": {\"events\": " << category.events
+            << ", \"height\": " << category.height << ", \"attendees\": " << category.attendees << "}";
+        first = false;
     }
+    out << "\n  },\n  \"checkin_queue\": {\"length\": " << checkInQueue.size()
+        << ", \"capacity\": " << checkInQueue.capacity()
+        << ", \"high_water\": " << instrumentation.queueHighWater.load() << "},\n";
 
-    EventNode* newEvent = new EventNode(id, name, type, importance);
+    out << "  \"search_depth\": [";
+    int deepest = deepestSearch();
+    for (int depth = 0; depth <= deepest; depth++) {
+        out << (depth ? ", " : "") << instrumentation.searchDepths[depth].load();
+    }
+    out << "],\n  \"journal_records\": " << instrumentation.journalRecords.load()
+        << ",\n  \"bytes_written\": " << instrumentation.bytesWritten.load()
+        << ",\n  \"last_snapshot_bytes\": " << instrumentation.lastSnapshotBytes.load()
+        << ",\n  \"operations\": {";
 
-    if (type == "seminar") {
-        insertEvent(seminars, newEvent);
-    } else if (type == "others"){
-      insertEvent(others, newEvent);
-    } else if (type == "sports") {
-        insertEvent(sports, newEvent);
-    } else if (type == "competition") {
-        insertEvent(competitions, newEvent);
-    } else {
-        cout << "Oops! That's not a valid event type." << endl;
-        delete newEvent;
-        return;
+    first = true;
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        const LatencyHistogram& histogram = instrumentation.latency[op];
+        out << (first ? "\n" : ",\n") << "    \"" << statOpNames[op] << "\": {\"count\": " << histogram.count.load()
+            << ", \"failed\": " << instrumentation.failures[op].load()
+            << ", \"total_ns\": " << histogram.totalNs.load()
+            << ", \"max_ns\": " << histogram.maxNs.load()
+            << ", \"log2_ns_buckets\": [";
+        for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+            out << (b ? ", " : "") << histogram.buckets[b].load();
+        }
+        out << "]}";
+        first = false;
     }
+    out << "\n  }\n}\n";
+}
 
-    cout << "Event created successfully!" << endl;
+bool saveStatistics(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                    const string& path) {
+    ostringstream json;
+    dumpStatistics(seminars, sports, competitions, others, json);
+    return writeFileAtomically(path, json.str());
 }
 
-void updateEventInfo(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
-    int id;
-    cout << "Enter the Event ID to update: ";
-    cin >> id;
+// The event with that ID in any of the snapshot's trees, null if there's none
+const EventVersion* findVersion(const CatalogVersion& catalog, int id) {
+    for (int i = 0; i < CATEGORY_COUNT; i++) {
+        const VersionNode* node = catalog.trees[i].get();
+        while (node) {
+            if (id == node->event->eventId) return node->event.get();
+            node = id < node->event->eventId ? node->left.get() : node->right.get();
+        }
+    }
+    return nullptr;
+}
 
-    // Search for the event in all categories (keep your existing search code)
-    EventNode* eventToUpdate = findEvent(seminars, id);
-    if (!eventToUpdate) eventToUpdate = findEvent(sports, id);
-    if (!eventToUpdate) eventToUpdate = findEvent(competitions, id);
-    if (!eventToUpdate) eventToUpdate = findEvent(others, id);
+// Generate comprehensive report. Output streams out in chunks while the snapshot is walked;
+// with a section limit only that many events (or schedule lines) are shown per section.
+// Nothing here reads the live trees, so it can run while other threads keep making changes.
+void generateReport(const CatalogVersion& catalog, ReportWriter& out) {
+    OpTimer timer(STAT_REPORT);
+    out << "\n=== EVENT MANAGEMENT SYSTEM REPORT ===\n\n";
 
-    if (!eventToUpdate) {
-        cout << "Event not found!" << endl;
-        return;
+    // how many events each category has, so a capped section can say how many it left out
+    vector<CategoryGauges> gauges = categoryGauges(catalog);
+    
+    // Events and Participants
+    out << "=== EVENTS AND PARTICIPANTS ===\n";
+    out << "\nSEMINARS:\n";
+    showAllEvents(out, catalog.trees[SEMINAR], gauges[0].events);
+    out << "\nSPORTS:\n";
+    showAllEvents(out, catalog.trees[SPORTS], gauges[1].events);
+    out << "\nCOMPETITIONS:\n";
+    showAllEvents(out, catalog.trees[COMPETITION], gauges[2].events);
+    out << "\nOTHERS:\n";
+    showAllEvents(out, catalog.trees[OTHERS], gauges[3].events);
+    
+    // Check-in Statistics, from the totals kept as people are checked in
+    out << "\n=== CHECK-IN STATISTICS ===\n";
+    out << "Current Queue Length: " << checkInQueue.size() << "\n";
+    vector<CheckInTotals> checkIns = checkInHistory.totals();
+    size_t checkedIn = 0;
+    for (const CheckInTotals& totals : checkIns) checkedIn += totals.arrived;
+    out << "Checked in so far: " << checkedIn << " at " << checkIns.size()
+        << (checkIns.size() == 1 ? " event\n" : " events\n");
+    out.beginSection();
+    for (const CheckInTotals& totals : checkIns) {
+        if (!out.takeRow()) continue;
+        const EventVersion* event = findVersion(catalog, totals.eventId);
+        out << (event ? event->name() : string("(removed event)")) << " (ID: " << totals.eventId << "): "
+            << totals.arrived;
+        if (event) out << " of " << event->attendeeCount << " registered";
+        out << ", first " << formatTime(totals.first) << ", last " << formatTime(totals.last) << "\n";
     }
+    out.endSection();
 
-    // Display current details (keep your existing display code)
-    cout << "Event found!" << endl;
-    cout << "Current details:" << endl;
-    // ... (rest of your display code)
+    // Persistence
+    out << "\n=== PERSISTENCE ===\n";
+    out << "Snapshots written: " << snapshotWriter.writtenCount()
+        << ", failed: " << snapshotWriter.failedCount()
+        << ", write pending: " << (snapshotWriter.pending() ? "yes" : "no") << "\n";
+    
+    // Priority Schedule, level 1 (high) first
+    out << "\n=== PRIORITY SCHEDULE ===\n";
+    vector<const EventVersion*> levels[3];
+    scheduleLevels(catalog, levels);
+    out.beginSection();
+    for (int level = 1; level <= 3; level++) {
+        for (const EventVersion* event : levels[level - 1]) {
+            if (!out.takeRow()) continue;
+            out << "Priority Level " << event->importanceLevel << ": "
+                << event->name() << " (ID: " << event->eventId << ")\n";
+        }
+    }
+    out.endSection();
 
-    cin.ignore();
-    string name, type;
-    int importance;
+    // Where the time goes
+    out << "\n=== STATISTICS ===\n";
+    ostringstream statistics;
+    printStatistics(gauges, statistics);
+    out << statistics.str();
+}
 
-    // Get new details (keep your existing input code)
-    cout << "Enter new name (or press Enter to keep the current name): ";
-    getline(cin, name);
+void generateReport(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others,
+                    ReportWriter& out) {
+    CatalogSnapshot snapshot = takeSnapshot(seminars, sports, competitions, others);
+    generateReport(*snapshot, out);
+}
 
-    cout << "Enter new type (Seminar/Sports/Competition/Others or press Enter to keep current type): ";
-    getline(cin, type);
-    transform(type.begin(), type.end(), type.begin(), ::tolower);
+void generateReport(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
+    ReportWriter out(cout);
+    generateReport(seminars, sports, competitions, others, out);
+}
 
-    cout << "Enter new importance level (1-3 or press 0 to keep current level): ";
-    cin >> importance;
+// Writes the report to a file instead of the screen
+bool writeReportToFile(const CatalogVersion& catalog, const string& path, size_t limitPerSection) {
+    ofstream file(path, ios::binary | ios::trunc);
+    if (!file.is_open()) return false;
+    {
+        ReportWriter out(file, limitPerSection);
+        generateReport(catalog, out);
+    }
+    return (bool)file;
+}
 
-    // Create and execute update command
-    Command* updateCmd = new UpdateEventCommand(eventToUpdate, name, type, importance);
-    commandManager.executeCommand(updateCmd);
 
-    cout << "Event updated successfully!" << endl;
-    
-    // Save changes
-    saveAllEvents(seminars, sports, competitions, others);
-}
+// ===== Operation replay and benchmarks =====
+// A trace is one operation per line, run through the headless API with no prompts.
+// Names run to the end of the line, lines starting with # are comments.
+//
+//   create <id> <importance> <type> <name>
+//   find <id>
+//   update <id> <importance, 0 keeps it> <type, - keeps it> <name, empty keeps it>
+//   remove <id>
+//   range <low id> <high id>
+//   search <name prefix>                 type-ahead, first 10 matches
+//   lookup <phone or name>               events that person is registered for
+//   register <id> <phone> <name>
+//   checkin <id> <name>
+//   process                              check in the next person in the queue
+//   schedule
+//   report
+//   undo
+//   redo
 
+enum TraceOp { OP_CREATE, OP_FIND, OP_UPDATE, OP_REMOVE, OP_RANGE, OP_SEARCH, OP_LOOKUP, OP_REGISTER,
+               OP_CHECKIN, OP_PROCESS, OP_SCHEDULE, OP_REPORT, OP_UNDO, OP_REDO, OP_COUNT };
 
-void registerNewAttendee(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
- 
-    string type;
-    int id;
-  
+const char* traceOpNames[OP_COUNT] = {"create", "find", "update", "remove", "range", "search", "lookup",
+                                      "register", "checkin", "process", "schedule", "report", "undo", "redo"};
 
-    EventNode* event = nullptr;
-    if (type == "seminar") event = findEvent(seminars, id);
-    else if (type == "sports") event = findEvent(sports, id);
-    else if (type == "competition") event = findEvent(competitions, id);
-    else if (type == "others") event = findEvent(others, id);
+struct OpStats {
+    vector<uint32_t> latenciesNs;
+    size_t failed = 0;
+    double totalSeconds = 0;
+};
 
-    if (!event) {
-        cout << "Couldn't find that event. Double-check the type and ID?" << endl;
-        return;
-    }
+struct ReplayStats {
+    OpStats ops[OP_COUNT];
+    size_t badLines = 0;
+    double seconds = 0;
+};
 
-    cout << "Found event: " << event->eventName << endl;
+// Swallows report and schedule output during a replay, but still makes the stream do the formatting
+class DiscardBuffer : public streambuf {
+private:
+    char scratch[4096];
 
-    char addMore;
-    do {
-        string name, phone;
-        cin.ignore();
+protected:
+    int overflow(int c) override {
+        setp(scratch, scratch + sizeof(scratch));
+        return traits_type::not_eof(c);
+    }
 
-        cout << "Attendee name: ";
-        getline(cin, name);
+public:
+    DiscardBuffer() { setp(scratch, scratch + sizeof(scratch)); }
+};
 
-        cout << "Phone number: ";
-        getline(cin, phone);
+// Splits the next space-separated word off the front of rest
+string_view nextWord(string_view& rest) {
+    rest = trimView(rest);
+    size_t end = rest.find(' ');
+    string_view word = rest.substr(0, end);
+    rest = end == string_view::npos ? string_view() : rest.substr(end + 1);
+    return word;
+}
 
-        Command* registerCmd = new AddAttendeeCommand(event, name, phone);
-        commandManager.executeCommand(registerCmd);
+// Runs every operation in the trace and times each one on its own. Parsing the line isn't timed.
+// Report and schedule output goes to reportOut.
+void replayTrace(string_view trace, EventNode*& seminars, EventNode*& sports, EventNode*& competitions,
+                 EventNode*& others, ReplayStats& stats, ostream& reportOut) {
+    auto replayStart = chrono::steady_clock::now();
+    string_view line;
+    while (nextLine(trace, line)) {
+        line = trimView(line);
+        if (line.empty() || line[0] == '#') continue;
 
-        saveAttendeeInfo(seminars, sports, competitions, others);
-        cout << "Attendee registered successfully!" << endl;
+        string_view word = nextWord(line);
+        int op = 0;
+        while (op < OP_COUNT && word != traceOpNames[op]) op++;
 
-        cout << "Register another? (y/n): ";
-        cin >> addMore;
-    } while (addMore == 'y' || addMore == 'Y');
-}
+        int id = 0, importance = 0, highId = 0;
+        string_view type, phone;
+        bool parsed = true;
+        switch (op) {
+            case OP_CREATE:
+            case OP_UPDATE:
+                parsed = parseNumber(nextWord(line), id) && parseNumber(nextWord(line), importance);
+                type = nextWord(line);
+                if (type == "-") type = string_view();
+                break;
+            case OP_REGISTER:
+                parsed = parseNumber(nextWord(line), id);
+                phone = nextWord(line);
+                break;
+            case OP_RANGE:
+                parsed = parseNumber(nextWord(line), id) && parseNumber(nextWord(line), highId);
+                break;
+            case OP_FIND:
+            case OP_REMOVE:
+            case OP_CHECKIN:
+                parsed = parseNumber(nextWord(line), id);
+                break;
+            case OP_COUNT:
+                parsed = false;
+                break;
+        }
+        if (!parsed) {
+            stats.badLines++;
+            continue;
+        }
+        string name(trimView(line));
 
+        bool ok = true;
+        auto start = chrono::steady_clock::now();
+        switch (op) {
+            case OP_CREATE:
+                ok = createEvent(seminars, sports, competitions, others, id, name, string(type), importance) != nullptr;
+                break;
+            case OP_FIND:
+                ok = findEventById(id) != nullptr;
+                break;
+            case OP_UPDATE:
+                ok = updateEvent(id, name, string(type), importance);
+                break;
+            case OP_REMOVE:
+                ok = removeEventById(seminars, sports, competitions, others, id);
+                break;
+            case OP_RANGE:
+                ok = !findEventsInRange(seminars, sports, competitions, others, id, highId).empty();
+                break;
+            case OP_SEARCH:
+                ok = !searchEventsByName(name, 10).empty();
+                break;
+            case OP_LOOKUP:
+                ok = !findRegistrations(name).empty();
+                break;
+            case OP_REGISTER:
+                ok = registerAttendee(id, name, string(phone));
+                break;
+            case OP_CHECKIN:
+                ok = queueCheckIn(id, name);
+                break;
+            case OP_PROCESS: {
+                CheckInResult result;
+                ok = checkInNext(result);
+                break;
+            }
+            case OP_SCHEDULE:
+            case OP_REPORT: {
+                ReportWriter out(reportOut);
+                CatalogSnapshot snapshot = takeSnapshot(seminars, sports, competitions, others);
+                if (op == OP_SCHEDULE) displaySchedule(*snapshot, out);
+                else generateReport(*snapshot, out);
+                break;
+            }
+            case OP_UNDO:
+                ok = undoOperation();
+                break;
+            case OP_REDO:
+                ok = redoOperation();
+                break;
+        }
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-void undoLastOperation(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
-    commandManager.undo();
-    saveAllEvents(seminars, sports, competitions, others);
-    saveAttendeeInfo(seminars, sports, competitions, others);
+        OpStats& opStats = stats.ops[op];
+        opStats.latenciesNs.push_back((uint32_t)min(elapsed * 1e9, 4e9));
+        opStats.totalSeconds += elapsed;
+        if (!ok) opStats.failed++;
+    }
+    stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - replayStart).count();
 }
 
-void redoLastOperation(EventNode*& seminars, EventNode*& sports, EventNode*& competitions, EventNode*& others) {
-    commandManager.redo();
-    saveAllEvents(seminars, sports, competitions, others);
-    saveAttendeeInfo(seminars, sports, competitions, others);
+// Latency at the given fraction (0.5 for p50) in microseconds. Reorders the samples.
+double latencyPercentile(vector<uint32_t>& samples, double fraction) {
+    if (samples.empty()) return 0;
+    size_t rank = min(samples.size() - 1, (size_t)(fraction * samples.size()));
+    nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank] / 1000.0;
 }
 
-void processCheckIn(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
-    int eventId;
-    string attendeeName;
-    
-    cout << "Enter Event ID: ";
-    cin >> eventId;
-    cin.ignore();
-    cout << "Enter Attendee Name: ";
-    getline(cin, attendeeName);
-    
-    // Get current timestamp, got this ENTIRELY from claudeAI
-    auto now = chrono::system_clock::now();
-    time_t currentTime = chrono::system_clock::to_time_t(now);
-    string timestamp = ctime(&currentTime);
-    timestamp = timestamp.substr(0, timestamp.length() - 1);  // Remove newline
-    
-    checkInQueue.push(CheckIn(eventId, attendeeName, timestamp));
-    cout << "Check-in queued successfully!\n";
+void printReplayStats(ReplayStats& stats) {
+    cout << "operation      count   failed        ops/sec    p50 (us)    p99 (us)\n";
+    for (int op = 0; op < OP_COUNT; op++) {
+        OpStats& opStats = stats.ops[op];
+        size_t count = opStats.latenciesNs.size();
+        if (count == 0) continue;
+        double throughput = opStats.totalSeconds > 0 ? count / opStats.totalSeconds : 0;
+        double p50 = latencyPercentile(opStats.latenciesNs, 0.50);
+        double p99 = latencyPercentile(opStats.latenciesNs, 0.99);
+        printf("%-10s %9zu %8zu %14.1f %11.2f %11.2f\n", traceOpNames[op], count, opStats.failed, throughput, p50, p99);
+    }
+    if (stats.badLines > 0) cout << stats.badLines << " trace lines couldn't be parsed\n";
+    cout << "Total: " << stats.seconds << " s\n";
 }
 
-//actually checks people in into the event
-void processNextCheckIn() {
-    if (checkInQueue.empty()) {
-        cout << "No one in the check-in queue.\n";
-        return;
+// A day's worth of traffic for eventCount events: create them all in random ID order, then
+// lookups, registrations, updates, check-ins, undo/redo, a few schedules and reports, and
+// finally remove a tenth of the events
+void generateTrace(ostream& out, int eventCount, unsigned seed) {
+    const char* types[] = {"seminar", "sports", "competition", "others"};
+    mt19937 random(seed);
+    auto anyEvent = [&]() { return (int)(random() % eventCount) + 1; };
+
+    vector<int> ids(eventCount);
+    for (int i = 0; i < eventCount; i++) ids[i] = i + 1;
+    shuffle(ids.begin(), ids.end(), random);
+    for (int id : ids) {
+        out << "create " << id << ' ' << (random() % 3 + 1) << ' ' << types[random() % 4] << " Event " << id << '\n';
     }
-    
-    CheckIn next = checkInQueue.front();
-    checkInQueue.pop();
-    
-    cout << "Processing check-in for:\n"
-         << "Attendee: " << next.attendeeName << "\n"
-         << "Event ID: " << next.eventId << "\n"
-         << "Check-in Time: " << next.timestamp << "\n";
-}
 
-// View next person in line
-void viewNextInLine() {
-    if (checkInQueue.empty()) {
-        cout << "No one in the check-in queue.\n";
-        return;
+    for (int i = 0; i < eventCount; i++) out << "find " << anyEvent() << '\n';
+    for (int i = 0; i < max(eventCount / 100, 1); i++) {
+        int low = anyEvent();
+        out << "range " << low << ' ' << low + 99 << '\n';
     }
-    
-    CheckIn next = checkInQueue.front();
-    cout << "Next in line:\n"
-         << "Attendee: " << next.attendeeName << "\n"
-         << "Event ID: " << next.eventId << "\n";
-}
 
+    // someone typing an event's name into the search box, one query per keystroke
+    for (int i = 0; i < max(eventCount / 100, 1); i++) {
+        string typed = "event " + to_string(anyEvent());
+        for (size_t length = 1; length <= typed.size(); length++) out << "search " << typed.substr(0, length) << '\n';
+    }
 
+    // remember who registered where so the check-ins are mostly valid
+    vector<pair<int, int>> registered;
+    for (int i = 0; i < eventCount / 2; i++) {
+        int id = anyEvent();
+        registered.push_back({id, i});
+        out << "register " << id << " 080" << (10000000 + i) << " Guest " << i << '\n';
+    }
 
-// Update priority queue with all events 
-void updatePriorityQueue(EventNode* root) {
-    if (!root) return;
-    
-    updatePriorityQueue(root->leftChild);
-    // Priority is negative of importance level so lower numbers have higher priority
-    eventPriorityQueue.push({-root->importanceLevel, root});
-    updatePriorityQueue(root->rightChild);
+    // the desk looking people up, mostly by phone, some by name, a few who never registered
+    for (int i = 0; i < max(eventCount / 10, 1); i++) {
+        int guest = (int)(random() % (registered.size() + registered.size() / 10 + 1));
+        if (i % 4 == 3) out << "lookup Guest " << guest << '\n';
+        else out << "lookup 080" << (10000000 + guest) << '\n';
+    }
+
+    for (int i = 0; i < eventCount / 10; i++) {
+        out << "update " << anyEvent() << ' ' << (random() % 3 + 1) << " - ";
+        if (i % 2 == 0) out << "Renamed " << i;
+        out << '\n';
+    }
+
+    for (size_t i = 0; i < registered.size(); i++) {
+        const pair<int, int>& guest = registered[random() % registered.size()];
+        out << "checkin " << guest.first << " Guest " << guest.second << '\n';
+        if (i % 8 == 7) {
+            for (int k = 0; k < 8; k++) out << "process\n";
+        }
+    }
+
+    for (int i = 0; i < max(eventCount / 100, 1); i++) out << "undo\nredo\n";
+    for (int i = 0; i < 5; i++) out << "schedule\n";
+    for (int i = 0; i < 2; i++) out << "report\n";
+
+    shuffle(ids.begin(), ids.end(), random);
+    for (int i = 0; i < eventCount / 10; i++) out << "remove " << ids[i] << '\n';
 }
 
-// Generate comprehensive report
-void generateReport(EventNode* seminars, EventNode* sports, EventNode* competitions, EventNode* others) {
-    cout << "\n=== EVENT MANAGEMENT SYSTEM REPORT ===\n\n";
-    
-    // Events and Participants
-    cout << "=== EVENTS AND PARTICIPANTS ===\n";
-    cout << "\nSEMINARS:\n";
-    showAllEvents(seminars);
-    cout << "\nSPORTS:\n";
-    showAllEvents(sports);
-    cout << "\nCOMPETITIONS:\n";
-    showAllEvents(competitions);
-    cout << "\nOTHERS:\n";
-    showAllEvents(others);
-    
-    // Check-in Statistics
-    cout << "\n=== CHECK-IN STATISTICS ===\n";
-    cout << "Current Queue Length: " << checkInQueue.size() << "\n";
-    
-    // Priority Schedule
-    cout << "\n=== PRIORITY SCHEDULE ===\n";
-    // Clear existing priority queue
-    while (!eventPriorityQueue.empty()) eventPriorityQueue.pop();
-    
-    // Update priority queue with all events
-    updatePriorityQueue(seminars);
-    updatePriorityQueue(sports);
-    updatePriorityQueue(competitions);
-    updatePriorityQueue(others);
-    
-    // Display events in priority order
-    while (!eventPriorityQueue.empty()) {
-        EventNode* event = eventPriorityQueue.top().second;
-        cout << "Priority Level " << -eventPriorityQueue.top().first << ": "
-             << event->eventName << " (ID: " << event->eventId << ")\n";
-        eventPriorityQueue.pop();
+// Generates and replays a trace for each catalog size, reporting throughput and latency per operation
+void benchmarkOperations(const vector<int>& eventCounts) {
+    EventNode *seminars = nullptr, *sports = nullptr, *competitions = nullptr, *others = nullptr;
+    DiscardBuffer discard;
+    ostream reportOut(&discard);
+
+    for (int eventCount : eventCounts) {
+        ostringstream trace;
+        generateTrace(trace, eventCount, 12345);
+        string traceText = trace.str();
+
+        releaseAllEvents(seminars, sports, competitions, others);
+        while (checkInQueue.size() > 0) {
+            CheckIn leftover;
+            checkInQueue.tryPop(leftover);
+        }
+
+        ReplayStats stats;
+        replayTrace(traceText, seminars, sports, competitions, others, stats, reportOut);
+        cout << "\n=== " << eventCount << " events ===\n";
+        printReplayStats(stats);
     }
+    releaseAllEvents(seminars, sports, competitions, others);
 }
 
 
 // The main function 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench-load") {
+        benchmarkLoad(argc > 2 ? stoi(argv[2]) : 200000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-checkin") {
+        benchmarkCheckIns(argc > 2 ? stoi(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        instrumentation.enabled = false;   // measure the operations themselves
+        vector<int> eventCounts;
+        for (int i = 2; i < argc; i++) eventCounts.push_back(stoi(argv[i]));
+        if (eventCounts.empty()) eventCounts = {10000, 100000, 1000000};
+        benchmarkOperations(eventCounts);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-lookup") {
+        instrumentation.enabled = false;
+        vector<int> eventCounts;
+        for (int i = 2; i < argc; i++) eventCounts.push_back(stoi(argv[i]));
+        if (eventCounts.empty()) eventCounts = {10000, 100000, 1000000};
+        benchmarkLookups(eventCounts);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-store") {
+        instrumentation.enabled = false;   // the shared counters would be what's measured
+        vector<int> threadCounts;
+        for (int i = 2; i < argc; i++) threadCounts.push_back(stoi(argv[i]));
+        if (threadCounts.empty()) {
+            for (int count = 1; count <= (int)max(thread::hardware_concurrency(), 4u); count *= 2) threadCounts.push_back(count);
+        }
+        benchmarkStore(100000, threadCounts);
+        return 0;
+    }
+    if (argc > 3 && string(argv[1]) == "--gen-trace") {
+        ofstream out(argv[3], ios::trunc);
+        generateTrace(out, stoi(argv[2]), 12345);
+        return 0;
+    }
+    if (argc > 2 && string(argv[1]) == "--replay") {
+        // runs against an empty system and touches none of the data files
+        MappedFile trace(argv[2]);
+        if (!trace.isOpen()) {
+            cout << "Couldn't open the trace " << argv[2] << endl;
+            return 1;
+        }
+        EventNode *seminars = nullptr, *sports = nullptr, *competitions = nullptr, *others = nullptr;
+        DiscardBuffer discard;
+        ostream reportOut(&discard);
+        ReplayStats stats;
+        replayTrace(trace.contents(), seminars, sports, competitions, others, stats, reportOut);
+        printReplayStats(stats);
+        if (argc > 3 && !saveStatistics(seminars, sports, competitions, others, argv[3])) {
+            cout << "Couldn't write " << argv[3] << endl;
+        }
+        releaseAllEvents(seminars, sports, competitions, others);
+        return 0;
+    }
+
     // Our four BSTs - one for each event type
     EventNode *seminars = nullptr, *sports = nullptr, *competitions = nullptr, *others = nullptr;
 
+    // Start from the last snapshot plus whatever the journal recorded after it
+    loadAllEvents(seminars, sports, competitions, others);
+    loadAttendeeInfo(seminars, sports, competitions, others);
+    int replayed = replayJournal(seminars, sports, competitions, others);
+    eventJournal.open();
+    checkInHistory.load();
+    restoreCheckedIn();
+    checkInHistory.open();
+
+    // From here on the files are kept up to date in the background
+    snapshotWriter.start([&]() { return writeSnapshot(seminars, sports, competitions, others); });
+    if (replayed > 0) snapshotWriter.markDirty();
+
     char keepGoing;
     do {
         cout << "\n=== Event Management System ===\n"
@@ -777,69 +5082,57 @@ int main() {
              << "10. Generate Report\n"
              << "11. Undo Last Operation\n"  
              << "12. Redo Last Operation\n"  
-             << "13. Exit.\n"
+             << "13. Process Check-in Batch\n"
+             << "14. Save Statistics (stats.json)\n"
+             << "15. Find Events by ID Range\n"
+             << "16. Search Events by Name\n"
+             << "17. Find an Attendee's Events\n"
+             << "18. Check-in History\n"
+             << "19. Import Attendees from a CSV File\n"
+             << "20. Exit.\n"
 
              << "Choose an option: ";
              
         int choice;
         cin >> choice;
 
+        // each action locks the state itself once its input is in, see lockState()
         switch (choice) {
             case 1:
                 createNewEvent(seminars, sports, competitions, others);
-                saveAllEvents(seminars, sports, competitions, others);
                 break;
             case 2: {
-                string type;
+                // by ID alone, the type doesn't say which tree the event is in (see homeTree)
                 int id;
-                cin.ignore();
-                cout << "Event type: ";
-                getline(cin, type);
-                transform(type.begin(), type.end(), type.begin(), ::tolower);
                 cout << "Event ID: ";
                 cin >> id;
                 
-                EventNode* event = nullptr;
-                if (type == "seminar") event = findEvent(seminars, id);
-                else if (type == "sports") event = findEvent(sports, id);
-                else if (type == "competition") event = findEvent(competitions, id);
-                else if (type == "others") event = findEvent(others, id);
-                
+                auto state = lockState();
+                EventNode* event = eventIndex.find(id);
                 if (event) showEventDetails(event);
                 else cout << "Event not found!\n";
                 break;
             }
             case 3:
-                registerNewAttendee(seminars, sports, competitions, others);
+                registerNewAttendee();
                 break;
-            case 4:
+            case 4: {
+                auto state = lockState();
                 displaySchedule(seminars, sports, competitions, others);
                 break;
+            }
             case 5: {
-                string type;
                 int id;
-                cin.ignore();
-                cout << "Event type to remove: ";
-                getline(cin, type);
-                transform(type.begin(), type.end(), type.begin(), ::tolower);
-                cout << "Event ID: ";
+                cout << "Event ID to remove: ";
                 cin >> id;
                 
-                if (type == "seminar") seminars = removeEvent(seminars, id);
-                else if (type == "sports") sports = removeEvent(sports, id);
-                else if (type == "sompetition") competitions = removeEvent(competitions, id);
-                else if (type == "others") competitions = removeEvent(others, id);
-                else cout << "Invalid event type!\n";
-                
-                saveAllEvents(seminars, sports, competitions, others);
-                saveAttendeeInfo(seminars, sports, competitions, others);
+                auto state = lockState();
+                if (!removeEventById(seminars, sports, competitions, others, id)) cout << "Event not found!\n";
                 break;
             }
 
             case 6: {
-              updateEventInfo(seminars, sports, competitions, others);
-              saveAllEvents(seminars, sports, competitions, others);
-              saveAttendeeInfo(seminars, sports, competitions, others);
+              updateEventInfo();
               break;
             }
             case 7:
@@ -851,16 +5144,131 @@ int main() {
             case 9:
             viewNextInLine();
             break;
-            case 10:
-            generateReport(seminars, sports, competitions, others);
-            break;
+            case 10: {
+                string path;
+                size_t limit = 0;
+                cin.ignore();
+                cout << "Save the report to a file (enter a file name, or just Enter for the screen): ";
+                getline(cin, path);
+                cout << "Events per section (0 for all): ";
+                cin >> limit;
+
+                // the report walks its own snapshot, so the snapshot writer doesn't wait for it
+                unique_lock<shared_mutex> state = lockState();
+                CatalogSnapshot snapshot = takeSnapshot(seminars, sports, competitions, others);
+                state.unlock();
+
+                if (path.empty()) {
+                    ReportWriter out(cout, limit);
+                    generateReport(*snapshot, out);
+                } else if (writeReportToFile(*snapshot, path, limit)) {
+                    cout << "Report written to " << path << "\n";
+                } else {
+                    cout << "Couldn't write the report to " << path << "\n";
+                }
+                break;
+            }
             case 11:
-            undoLastOperation(seminars, sports, competitions, others);
+            undoLastOperation();
             break;
             case 12:
-            redoLastOperation(seminars, sports, competitions, others);
+            redoLastOperation();
             break;
             case 13:
+            processCheckInQueueBatch();
+            break;
+            case 14: {
+                auto state = lockState();
+                if (saveStatistics(seminars, sports, competitions, others, "stats.json")) {
+                    cout << "Statistics saved to stats.json\n";
+                } else {
+                    cout << "Couldn't write stats.json\n";
+                }
+                break;
+            }
+            case 15: {
+                int lowId, highId;
+                cout << "From Event ID: ";
+                cin >> lowId;
+                cout << "To Event ID: ";
+                cin >> highId;
+
+                auto state = lockState();
+                vector<EventNode*> found = findEventsInRange(seminars, sports, competitions, others, lowId, highId);
+                if (found.empty()) {
+                    cout << "No events in that range.\n";
+                    break;
+                }
+                for (EventNode* event : found) {
+                    cout << event->eventId << ": " << event->name() << " (" << event->type()
+                         << ", priority " << event->importanceLevel << ")\n";
+                }
+                cout << found.size() << " events found.\n";
+                break;
+            }
+            case 16: {
+                string text;
+                cin.ignore();
+                cout << "Name (or the start of any word in it): ";
+                getline(cin, text);
+
+                auto state = lockState();
+                vector<EventNode*> found = searchEventsByName(text, 20);
+                if (found.empty()) {
+                    cout << "No events match that.\n";
+                    break;
+                }
+                for (EventNode* event : found) {
+                    cout << event->eventId << ": " << event->name() << " (" << event->type()
+                         << ", priority " << event->importanceLevel << ")\n";
+                }
+                break;
+            }
+            case 17: {
+                string text;
+                cin.ignore();
+                cout << "Phone number or attendee name: ";
+                getline(cin, text);
+
+                auto state = lockState();
+                vector<EventNode*> found = findRegistrations(text);
+                if (found.empty()) {
+                    cout << "Nobody by that number or name is registered for anything.\n";
+                    break;
+                }
+                for (EventNode* event : found) {
+                    cout << event->eventId << ": " << event->name() << " (" << event->type()
+                         << ", priority " << event->importanceLevel << ")\n";
+                }
+                cout << "Registered for " << found.size() << (found.size() == 1 ? " event.\n" : " events.\n");
+                break;
+            }
+            case 18:
+                showCheckInHistory();   // the history has its own lock
+                break;
+            case 19: {
+                string path;
+                cin.ignore();
+                cout << "CSV file (event ID, name, phone on each row): ";
+                getline(cin, path);
+
+                unique_lock<shared_mutex> state = lockState();
+                ImportSummary summary = importAttendees(path);
+                state.unlock();
+                if (!summary.opened) {
+                    cout << "Couldn't open " << path << "\n";
+                    break;
+                }
+                cout << "Imported " << summary.imported << " of " << summary.rows << " rows into "
+                     << summary.events << (summary.events == 1 ? " event" : " events") << ".\n";
+                if (summary.duplicates) cout << summary.duplicates << " already registered, skipped.\n";
+                if (summary.unknownEvent) cout << summary.unknownEvent << " for events that don't exist, skipped.\n";
+                if (summary.malformed) cout << summary.malformed << " rows couldn't be read, skipped.\n";
+                if (summary.imported) cout << "Undo takes the whole import back.\n";
+                break;
+            }
+            case 20:
+                snapshotWriter.shutdown();
                 cout << "Thanks for using the system! Goodbye!\n";
                 return 0;
             default:
@@ -871,5 +5279,6 @@ int main() {
         cin >> keepGoing;
     } while (keepGoing == 'y' || keepGoing == 'Y');
 
+    snapshotWriter.shutdown();
     return 0;
 }
\ No newline at end of file
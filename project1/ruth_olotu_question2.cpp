@@ -14,6 +14,7 @@
 #include <queue>
 #include <list>
 #include <map>
+#include "intrusive_tree.h"
 using namespace std;
 
 struct Package {
@@ -26,14 +27,22 @@ struct Package {
     string deliveryRoute;    // Added for route tracking
     Package* leftChild;    
     Package* rightChild;   
+    bool red;                // colour of the link from the parent, for the red-black balancing
 
     Package(int tracking, string address, string customer, string recipient, 
             int urgency, string route) 
         : trackingNumber(tracking), deliveryAddress(address), customerName(customer), 
           recipientName(recipient), urgencyLevel(urgency), status("pending"),
-          deliveryRoute(route), leftChild(nullptr), rightChild(nullptr) {}
+          deliveryRoute(route), leftChild(nullptr), rightChild(nullptr), red(false) {}
 };
 
+// The package tree is the same intrusive tree the event system uses (intrusive_tree.h), keyed on
+// the tracking number. Red-black rather than AVL since packages get added and removed (undo/redo)
+// about as often as they're looked up, and red-black rotates less on those.
+typedef intrusive::TreeAlgorithms<Package, intrusive::MemberKey<Package, int, &Package::trackingNumber>,
+                                  intrusive::ChildLinks<Package, &Package::leftChild, &Package::rightChild>,
+                                  intrusive::RedBlackBalancing<Package, &Package::red>> PackageTree;
+
 // Global data structures
 queue<Package*> deliveryVan;              // For current deliveries
 list<Package*> deliveredPackages;         // Linked list for delivered packages
@@ -52,12 +61,11 @@ struct PackageUrgencySort {
 
 // Enhanced version of collectPackagesForDelivery
 void collectPackagesForDelivery(Package* root, priority_queue<Package*, vector<Package*>, PackageUrgencySort>& priorityQueue) {
-    if (!root) return;
-    if (root->status == "pending") {  // Only add pending packages
-        priorityQueue.push(root);
-    }
-    collectPackagesForDelivery(root->leftChild, priorityQueue);
-    collectPackagesForDelivery(root->rightChild, priorityQueue);
+    PackageTree::forEach(root, [&priorityQueue](Package* pkg) {
+        if (pkg->status == "pending") {  // Only add pending packages
+            priorityQueue.push(pkg);
+        }
+    });
 }
 
 // Enhanced file operations
@@ -121,8 +129,9 @@ void completeDeliveries() {
     cout << "All packages delivered successfully!" << endl;
 }
 
-// Enhanced van state restoration
-void restoreDeliveryVanState() {
+// Enhanced van state restoration. Packages already in the database are put back in the van as
+// they are, so delivering them updates the same package the tree and the lists have.
+void restoreDeliveryVanState(Package* root) {
     ifstream vanFile("Truck.txt");
     if (!vanFile.is_open()) {
         cout << "No previous delivery van data found." << endl;
@@ -151,108 +160,58 @@ void restoreDeliveryVanState() {
         route = route.substr(route.find_first_not_of(" "));
         route = route.substr(0, route.find_last_not_of(" ") + 1);
 
-        Package* pkg = new Package(
-            stoi(tracking), 
-            address, 
-            customer,
-            recipient,
-            stoi(urgency),
-            route
-        );
+        Package* pkg = PackageTree::find(root, stoi(tracking));
+        if (!pkg) {
+            pkg = new Package(
+                stoi(tracking), 
+                address, 
+                customer,
+                recipient,
+                stoi(urgency),
+                route
+            );
+        }
         pkg->status = "in-van";
         deliveryVan.push(pkg);
     }
     vanFile.close();
 }
 
-// Enhanced package finding functions
+// Enhanced package finding functions. Goes in tracking number order, so with several packages
+// for the same recipient it's the lowest tracking number that comes back
 Package* findPackageByRecipient(Package* root, string recipient) {
-    if (!root) return nullptr;
-    
-    if (root->recipientName == recipient) return root;
-    
-    Package* left = findPackageByRecipient(root->leftChild, recipient);
-    if (left) return left;
-    
-    return findPackageByRecipient(root->rightChild, recipient);
-}
-
-Package* findSmallestTracking(Package* node) {
-    while (node->leftChild) {
-        node = node->leftChild;
+    for (PackageTree::Iterator it(root); !it.done(); it.next()) {
+        if (it.current()->recipientName == recipient) return it.current();
     }
-    return node;
+    return nullptr;
 }
 
-// Enhanced package removal with undo support
+// Takes the package out of the tree and hands back the new root. The package itself isn't deleted
+// (or copied over by its successor), the undo/redo history still points at it.
 Package* removePackage(Package* root, int tracking) {
-    if (!root) {
+    if (!PackageTree::unlink(root, tracking)) {
         cout << "Package not found!" << endl;
-        return root;
-    }
-
-    if (tracking < root->trackingNumber) {
-        root->leftChild = removePackage(root->leftChild, tracking);
-    } 
-    else if (tracking > root->trackingNumber) {
-        root->rightChild = removePackage(root->rightChild, tracking);
-    }
-    else {
-        // Add to undo stack before removing
-        undoStack.push({"remove", root});
-        
-        if (!root->leftChild && !root->rightChild) {
-            delete root;
-            return nullptr;
-        }
-        else if (!root->leftChild) {
-            Package* temp = root->rightChild;
-            delete root;
-            return temp;
-        }
-        else if (!root->rightChild) {
-            Package* temp = root->leftChild;
-            delete root;
-            return temp;
-        }
-        else {
-            Package* successor = findSmallestTracking(root->rightChild);
-            root->trackingNumber = successor->trackingNumber;
-            root->customerName = successor->customerName;
-            root->recipientName = successor->recipientName;
-            root->deliveryAddress = successor->deliveryAddress;
-            root->deliveryRoute = successor->deliveryRoute;
-            root->urgencyLevel = successor->urgencyLevel;
-            root->status = successor->status;
-            root->rightChild = removePackage(root->rightChild, successor->trackingNumber);
-        }
     }
     return root;
 }
 
 // Enhanced package finding
 Package* findPackage(Package* root, int tracking) {
-    if (!root || root->trackingNumber == tracking) return root;
-    
-    if (tracking < root->trackingNumber) {
-        return findPackage(root->leftChild, tracking);
-    }
-    return findPackage(root->rightChild, tracking);
+    return PackageTree::find(root, tracking);
 }
 
 // Enhanced file operations
+// In tracking number order, the tree balances itself on load so the file order doesn't matter
 void savePackageToFile(ofstream &outFile, Package* root) {
-    if (root) {
-        outFile << root->trackingNumber << ", " 
-               << root->customerName << ", "
-               << root->recipientName << ", "
-               << root->deliveryAddress << ", "
-               << root->deliveryRoute << ", "
-               << root->urgencyLevel << ", "
-               << root->status << "\n";
-        
-        savePackageToFile(outFile, root->leftChild);
-        savePackageToFile(outFile, root->rightChild);
+    for (PackageTree::Iterator it(root); !it.done(); it.next()) {
+        Package* pkg = it.current();
+        outFile << pkg->trackingNumber << ", " 
+               << pkg->customerName << ", "
+               << pkg->recipientName << ", "
+               << pkg->deliveryAddress << ", "
+               << pkg->deliveryRoute << ", "
+               << pkg->urgencyLevel << ", "
+               << pkg->status << "\n";
     }
 }
 
@@ -287,21 +246,15 @@ void loadVanForDelivery(Package*& root) {
     cout << "Van loaded with highest priority packages!" << endl;
 }
 
-// Enhanced package addition with undo support
-void addPackageToSystem(Package*& root, Package* newPackage) {
+// Enhanced package addition with undo support. False if the tracking number is already taken.
+bool addPackageToSystem(Package*& root, Package* newPackage) {
+    if (!PackageTree::insert(root, newPackage)) {
+        cout << "A package with that tracking number is already in the system!" << endl;
+        return false;
+    }
     undoStack.push({"add", newPackage});
     pendingPackages.push_back(newPackage);
-    
-    if (!root) {
-        root = newPackage;
-        return;
-    }
-    
-    if (newPackage->trackingNumber < root->trackingNumber) {
-        addPackageToSystem(root->leftChild, newPackage);
-    } else {
-        addPackageToSystem(root->rightChild, newPackage);
-    }
+    return true;
 }
 
 // Enhanced database loading
@@ -335,7 +288,8 @@ void loadPackageDatabase(Package*& root) {
         route = route.substr(route.find_first_not_of(" "));
         route = route.substr(0, route.find_last_not_of(" ") + 1);
 
-        Package* newPackage = new Package(
+        // loading isn't something to undo, so this goes straight into the tree
+        Package* newPackage = PackageTree::emplace(root,
             stoi(tracking),
             address,
             customer,
@@ -343,9 +297,11 @@ void loadPackageDatabase(Package*& root) {
             stoi(urgency),
             route
         );
+        if (!newPackage) {
+            cout << "Skipping duplicate tracking number " << stoi(tracking) << endl;
+            continue;
+        }
         newPackage->status = status;
-
-        addPackageToSystem(root, newPackage);
         if (status == "delivered") {
             deliveredPackages.push_back(newPackage);
         } else if (status == "pending") {
@@ -446,15 +402,10 @@ void undoLastAction(Package*& root) {
     
     if (lastAction.first == "add") {
         // Remove package from BST and pending list
-        removePackage(root, lastAction.second->trackingNumber);
+        root = removePackage(root, lastAction.second->trackingNumber);
         pendingPackages.remove(lastAction.second);
         redoStack.push(lastAction);
     }
-    else if (lastAction.first == "remove") {
-        // Re-add package to BST
-        addPackageToSystem(root, lastAction.second);
-        redoStack.push({"add", lastAction.second});
-    }
     else if (lastAction.first == "load") {
         // Remove from delivery van and set status back to pending
         queue<Package*> tempVan;
@@ -495,11 +446,13 @@ void redoLastAction(Package*& root) {
     redoStack.pop();
     
     if (lastAction.first == "add") {
-        addPackageToSystem(root, lastAction.second);
-        undoStack.push(lastAction);
-    }
-    else if (lastAction.first == "remove") {
-        removePackage(root, lastAction.second->trackingNumber);
+        if (!PackageTree::insert(root, lastAction.second)) {
+            cout << "Can't redo, another package now has tracking number "
+                 << lastAction.second->trackingNumber << "!" << endl;
+            redoStack.push(lastAction);
+            return;
+        }
+        pendingPackages.push_back(lastAction.second);
         undoStack.push(lastAction);
     }
     else if (lastAction.first == "load") {
@@ -547,7 +500,7 @@ void displayMenu() {
 int main() {
     Package* root = nullptr;
     loadPackageDatabase(root);
-    restoreDeliveryVanState();
+    restoreDeliveryVanState(root);
 
     int choice;
     do {